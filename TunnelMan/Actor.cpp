@@ -1,19 +1,24 @@
 #include "Actor.h"
 #include "StudentWorld.h"
 #include "GameConstants.h"
-#include <cmath>
+#include "Snapshot.h"
 #include <cstdlib>
 
 // ============================================================================
 // HELPERS
 // ============================================================================
 
-double Actor::getDistanceTo(int x, int y) const {
-    return std::sqrt(std::pow(getX() - x, 2) + std::pow(getY() - y, 2));
+Actor::Actor(int imageID, int startX, int startY, StudentWorld* world, Direction dir, double size, unsigned int depth)
+    : GraphObject(imageID, startX, startY, dir, size, depth, &world->getGraphObjects()), m_world(world), m_isAlive(true),
+    m_componentKind(NO_COMPONENTS), m_componentRow(-1)
+{
+    setVisible(true);
 }
 
-double Actor::getDistanceTo(Actor* other) const {
-    return getDistanceTo(other->getX(), other->getY());
+void Actor::moveTo(int x, int y) {
+    int oldX = getX(), oldY = getY();
+    GraphObject::moveTo(x, y);
+    m_world->actorMoved(this, oldX, oldY);
 }
 
 void Agent::decHP(int amount) {
@@ -21,6 +26,14 @@ void Agent::decHP(int amount) {
     // Base Agent logic does not auto-kill; derived classes handle state
 }
 
+void Agent::saveState(SnapshotWriter& out) const {
+    out.put(m_hp);
+}
+
+void Agent::loadState(SnapshotReader& in) {
+    m_hp = in.get<int>();
+}
+
 // ============================================================================
 // TUNNELMAN
 // ============================================================================
@@ -30,6 +43,20 @@ Tunnelman::Tunnelman(StudentWorld* world)
 {
 }
 
+void Tunnelman::saveState(SnapshotWriter& out) const {
+    Agent::saveState(out);
+    out.put(m_gold);
+    out.put(m_sonar);
+    out.put(m_water);
+}
+
+void Tunnelman::loadState(SnapshotReader& in) {
+    Agent::loadState(in);
+    m_gold = in.get<int>();
+    m_sonar = in.get<int>();
+    m_water = in.get<int>();
+}
+
 void Tunnelman::decHP(int amount) {
     Agent::decHP(amount);
     if (getHP() <= 0) setDead();
@@ -82,7 +109,7 @@ void Tunnelman::doSomething()
                 if (getDirection() == down) sy -= 4;
 
                 if (getWorld()->isLocationAccessible(sx, sy)) {
-                    getWorld()->addActor(new Squirt(sx, sy, getWorld(), getDirection()));
+                    getWorld()->spawnActor<Squirt>(sx, sy, getWorld(), getDirection());
                 }
             }
             break;
@@ -90,14 +117,14 @@ void Tunnelman::doSomething()
         case 'Z':
             if (m_sonar > 0) {
                 m_sonar--;
-                getWorld()->scanForItems(getX(), getY(), 12);
+                getWorld()->scanForItems(getX(), getY(), SONAR_RADIUS);
                 getWorld()->playSound(SOUND_SONAR);
             }
             break;
         case KEY_PRESS_TAB:
             if (m_gold > 0) {
                 m_gold--;
-                getWorld()->addActor(new GoldNugget(getX(), getY(), getWorld(), true, false, true));
+                getWorld()->spawnActor<GoldNugget>(getX(), getY(), getWorld(), true, false, true);
             }
             break;
         }
@@ -110,10 +137,36 @@ void Tunnelman::doSomething()
 
 Protester::Protester(StudentWorld* world, int imageID, int hp)
     : Agent(imageID, 60, 60, world, hp, left),
-    m_numSquaresToMove(rand() % 53 + 8), m_ticksToWait(0), m_leaving(false),
+    m_numSquaresToMove(world->randInt(53) + 8), m_leaving(false),
     m_stunTicks(0), m_ticksSincePerpendicularTurn(200), m_ticksSinceLastShout(15)
 {
-    m_ticksToWait = std::max(0, 3 - (int)world->getLevel() / 4);
+}
+
+int Protester::getRestingTicks() const {
+    return std::max(0, 3 - (int)getWorld()->getLevel() / 4);
+}
+
+void Protester::setTicksToWait(int ticks) {
+    getWorld()->setProtesterRest(this, ticks);
+}
+
+// The rest countdown is not here: the world saves it with the protester's table row
+void Protester::saveState(SnapshotWriter& out) const {
+    Agent::saveState(out);
+    out.put(m_stunTicks);
+    out.put(m_numSquaresToMove);
+    out.put(m_leaving);
+    out.put(m_ticksSincePerpendicularTurn);
+    out.put(m_ticksSinceLastShout);
+}
+
+void Protester::loadState(SnapshotReader& in) {
+    Agent::loadState(in);
+    m_stunTicks = in.get<int>();
+    m_numSquaresToMove = in.get<int>();
+    m_leaving = in.get<bool>();
+    m_ticksSincePerpendicularTurn = in.get<int>();
+    m_ticksSinceLastShout = in.get<int>();
 }
 
 bool Protester::canBeAnnoyed() const {
@@ -123,111 +176,125 @@ bool Protester::canBeAnnoyed() const {
 void Protester::doSomething()
 {
     if (!isAlive()) return;
+    if (isHardcore()) getWorld()->updatePlayerField(getTrackingRange());
+    applyMove(planMove());
+}
 
-    // 1. Check Rest
-    if (m_ticksToWait > 0) {
-        m_ticksToWait--;
-        return;
+int Protester::getTrackingRange() const {
+    return isHardcore() ? 16 + (int)getWorld()->getLevel() * 2 : 0;
+}
+
+// Everything here is read from the player, the map and this protester, none of
+// which another protester changes during the pass. Hardcore tracking needs the
+// player field already built to getTrackingRange().
+ProtesterPlan Protester::planMove() const
+{
+    ProtesterPlan plan = { ProtesterPlan::WANDER, none, false, 0 };
+    StudentWorld* world = getWorld();
+
+    // Leaving: head for the exit
+    if (m_leaving) {
+        plan.action = ProtesterPlan::LEAVE;
+        if (getX() != 60 || getY() != 60) plan.dir = world->getDirectionToExit(getX(), getY());
+        return plan;
+    }
+
+    // Attack / Proximity Logic (Prevent Overshoot/Zig-Zag)
+    // If we are in "Attacking Range" (<= 4.0), we STOP moving.
+    // This prevents running past the player.
+    const Tunnelman* player = world->getPlayer();
+    if (isWithin(player, SHOUT_RADIUS)) {
+        plan.action = ProtesterPlan::CONFRONT;
+        plan.facingPlayer = isFacingPlayer();
+        if (!plan.facingPlayer && isHardcore()) {
+            // Hardcore protesters turn to face the player when lined up
+            if (player->getY() == getY())
+                plan.dir = (player->getX() < getX()) ? left : right;
+            else if (player->getX() == getX())
+                plan.dir = (player->getY() < getY()) ? down : up;
+        }
+        return plan;
     }
 
+    // Hardcore Tracking (only outside attack range, to prevent close-range spazzing)
+    if (isHardcore()) {
+        Direction d = world->readDirectionToPlayer(getX(), getY(), getTrackingRange());
+        if (d != none) {
+            plan.action = ProtesterPlan::TRACK;
+            plan.dir = d;
+            return plan;
+        }
+    }
+
+    // Line of Sight
+    if (hasLineOfSightToPlayer()) {
+        plan.action = ProtesterPlan::CHASE;
+        if (player->getY() == getY())
+            plan.dir = (player->getX() < getX()) ? left : right;
+        else
+            plan.dir = (player->getY() < getY()) ? down : up;
+        return plan;
+    }
+
+    // Regular Movement: all that is left to decide needs the random stream, so just note the way out
+    if (world->isLocationAccessible(getX(), getY() + 1)) plan.open |= 1 << up;
+    if (world->isLocationAccessible(getX(), getY() - 1)) plan.open |= 1 << down;
+    if (world->isLocationAccessible(getX() - 1, getY())) plan.open |= 1 << left;
+    if (world->isLocationAccessible(getX() + 1, getY())) plan.open |= 1 << right;
+    return plan;
+}
+
+// Carries out a plan from planMove(): every write and every random draw happens
+// here, one protester at a time in pass order
+void Protester::applyMove(const ProtesterPlan& plan)
+{
+    if (!isAlive()) return;
+
+    // Rest is counted down by the world's protester pass, which only calls us once it is over
+
     // Calculate normal speed for reset
-    int restingTicks = std::max(0, 3 - (int)getWorld()->getLevel() / 4);
+    int restingTicks = getRestingTicks();
 
     // Default next wait is the standard speed
     // This applies to both Hunting AND Leaving now (Correct Speed)
-    m_ticksToWait = restingTicks;
+    setTicksToWait(restingTicks);
 
     m_ticksSincePerpendicularTurn++;
     m_ticksSinceLastShout++;
 
-    // 2. Leaving State
-    if (m_leaving) {
-        if (getX() == 60 && getY() == 60) {
-            setDead();
-            return;
-        }
-        Direction dir = getWorld()->getDirectionToExit(getX(), getY());
-        if (dir != none) {
-            setDirection(dir);
-            if (dir == up) moveTo(getX(), getY() + 1);
-            if (dir == down) moveTo(getX(), getY() - 1);
-            if (dir == left) moveTo(getX() - 1, getY());
-            if (dir == right) moveTo(getX() + 1, getY());
-        }
+    switch (plan.action) {
+    case ProtesterPlan::LEAVE:
+        if (getX() == 60 && getY() == 60) setDead();
+        else if (plan.dir != none) step(plan.dir);
         return;
-    }
-
-    // 3. Attack / Proximity Logic (Prevent Overshoot/Zig-Zag)
-    double distToPlayer = getDistanceTo(getWorld()->getPlayer());
-
-    // If we are in "Attacking Range" (<= 4.0), we STOP moving.
-    // This prevents running past the player.
-    if (distToPlayer <= 4.0) {
-
-        if (isFacingPlayer()) {
+    case ProtesterPlan::CONFRONT:
+        if (plan.facingPlayer) {
             if (m_ticksSinceLastShout >= 15) {
                 getWorld()->playSound(SOUND_PROTESTER_YELL);
                 getWorld()->getPlayer()->decHP(2);
                 m_ticksSinceLastShout = 0;
-                m_ticksToWait = std::max(15, restingTicks * 2); // Pause after shout
-                return;
+                setTicksToWait(std::max(15, restingTicks * 2)); // Pause after shout
             }
             // Cooldown active: Stand still.
-            return;
         }
-        else {
-            // Close but not facing. Do not move (prevents walking past).
-            // Hardcore logic to rotate:
-            if (isHardcore()) {
-                // Try to face player
-                Direction d = none;
-                if (getWorld()->getPlayer()->getY() == getY())
-                    d = (getWorld()->getPlayer()->getX() < getX()) ? left : right;
-                else if (getWorld()->getPlayer()->getX() == getX())
-                    d = (getWorld()->getPlayer()->getY() < getY()) ? down : up;
-                if (d != none) setDirection(d);
-            }
-            return;
+        else if (plan.dir != none) {
+            setDirection(plan.dir); // close but not facing: turn without moving
         }
-    }
-
-    // 4. Hardcore Tracking
-    // Only track if OUTSIDE attack range (> 4.0) to prevent close-range spazzing
-    if (isHardcore() && distToPlayer > 4.0) {
-        int M = 16 + getWorld()->getLevel() * 2;
-        Direction d = getWorld()->getDirectionToPlayer(getX(), getY(), M);
-        if (d != none) {
-            setDirection(d);
-            if (d == up) moveTo(getX(), getY() + 1);
-            if (d == down) moveTo(getX(), getY() - 1);
-            if (d == left) moveTo(getX() - 1, getY());
-            if (d == right) moveTo(getX() + 1, getY());
-            return;
-        }
-    }
-
-    // 5. Line of Sight
-    if (hasLineOfSightToPlayer() && distToPlayer > 4.0) {
-        Direction d = none;
-        if (getWorld()->getPlayer()->getY() == getY())
-            d = (getWorld()->getPlayer()->getX() < getX()) ? left : right;
-        else
-            d = (getWorld()->getPlayer()->getY() < getY()) ? down : up;
-
-        setDirection(d);
-        if (d == up) moveTo(getX(), getY() + 1);
-        if (d == down) moveTo(getX(), getY() - 1);
-        if (d == left) moveTo(getX() - 1, getY());
-        if (d == right) moveTo(getX() + 1, getY());
-
+        return;
+    case ProtesterPlan::TRACK:
+        step(plan.dir);
+        return;
+    case ProtesterPlan::CHASE:
+        step(plan.dir);
         m_numSquaresToMove = 0;
         return;
+    case ProtesterPlan::WANDER:
+        break;
     }
 
-    // 6. Regular Movement
     m_numSquaresToMove--;
     if (m_numSquaresToMove <= 0) {
-        pickNewDirection();
+        pickNewDirection(plan.open);
     }
     else {
         // Intersection Turn
@@ -240,41 +307,36 @@ void Protester::doSomething()
                 perp1 = left; perp2 = right;
             }
 
-            bool can1 = (perp1 == up) ? getWorld()->isLocationAccessible(getX(), getY() + 1) :
-                (perp1 == down) ? getWorld()->isLocationAccessible(getX(), getY() - 1) :
-                (perp1 == left) ? getWorld()->isLocationAccessible(getX() - 1, getY()) :
-                getWorld()->isLocationAccessible(getX() + 1, getY());
-
-            bool can2 = (perp2 == up) ? getWorld()->isLocationAccessible(getX(), getY() + 1) :
-                (perp2 == down) ? getWorld()->isLocationAccessible(getX(), getY() - 1) :
-                (perp2 == left) ? getWorld()->isLocationAccessible(getX() - 1, getY()) :
-                getWorld()->isLocationAccessible(getX() + 1, getY());
+            bool can1 = (plan.open >> perp1) & 1;
+            bool can2 = (plan.open >> perp2) & 1;
 
             if (can1 || can2) {
-                if (can1 && can2) setDirection((rand() % 2 == 0) ? perp1 : perp2);
+                if (can1 && can2) setDirection((getWorld()->randInt(2) == 0) ? perp1 : perp2);
                 else if (can1) setDirection(perp1);
                 else setDirection(perp2);
 
-                m_numSquaresToMove = rand() % 53 + 8;
+                m_numSquaresToMove = getWorld()->randInt(53) + 8;
                 m_ticksSincePerpendicularTurn = 0;
             }
         }
     }
 
-    int tx = getX(), ty = getY();
-    if (getDirection() == up) ty++;
-    else if (getDirection() == down) ty--;
-    else if (getDirection() == left) tx--;
-    else if (getDirection() == right) tx++;
-
-    if (getWorld()->isLocationAccessible(tx, ty)) {
-        moveTo(tx, ty);
+    if ((plan.open >> getDirection()) & 1) {
+        step(getDirection());
     }
     else {
         m_numSquaresToMove = 0;
     }
 }
 
+void Protester::step(Direction dir) {
+    setDirection(dir);
+    if (dir == up) moveTo(getX(), getY() + 1);
+    if (dir == down) moveTo(getX(), getY() - 1);
+    if (dir == left) moveTo(getX() - 1, getY());
+    if (dir == right) moveTo(getX() + 1, getY());
+}
+
 void Protester::decHP(int amount) {
     if (m_leaving) return;
 
@@ -283,7 +345,7 @@ void Protester::decHP(int amount) {
     if (getHP() > 0) {
         getWorld()->playSound(SOUND_PROTESTER_ANNOYED);
         int N = std::max(50, 100 - (int)getWorld()->getLevel() * 10);
-        m_ticksToWait = N; // STUN
+        setTicksToWait(N); // STUN
     }
     else {
         if (!m_leaving) {
@@ -296,7 +358,7 @@ void Protester::decHP(int amount) {
             // Optional: If you want them to react immediately (but obey speed on next step),
             // you can leave m_ticksToWait alone or set it to 0 only if you want the *first* step instant.
             // To be safe and prevent "too fast" complaints, we let them wait out their current cycle.
-            m_ticksToWait = 0; // Set to 0 to start moving *on next tick cycle*, but loop above resets it to restingTicks.
+            setTicksToWait(0); // Set to 0 to start moving *on next tick cycle*, but loop above resets it to restingTicks.
         }
     }
 }
@@ -326,20 +388,14 @@ bool Protester::hasLineOfSightToPlayer() const {
     return true;
 }
 
-void Protester::pickNewDirection() {
-    int dir = rand() % 4;
+void Protester::pickNewDirection(unsigned char open) {
+    int dir = getWorld()->randInt(4);
     Direction d;
     if (dir == 0) d = up; else if (dir == 1) d = down; else if (dir == 2) d = left; else d = right;
 
-    bool blocked = false;
-    if (d == up && !getWorld()->isLocationAccessible(getX(), getY() + 1)) blocked = true;
-    if (d == down && !getWorld()->isLocationAccessible(getX(), getY() - 1)) blocked = true;
-    if (d == left && !getWorld()->isLocationAccessible(getX() - 1, getY())) blocked = true;
-    if (d == right && !getWorld()->isLocationAccessible(getX() + 1, getY())) blocked = true;
-
-    if (!blocked) {
+    if ((open >> d) & 1) {
         setDirection(d);
-        m_numSquaresToMove = rand() % 53 + 8;
+        m_numSquaresToMove = getWorld()->randInt(53) + 8;
     }
     else {
         m_numSquaresToMove = 0;
@@ -361,7 +417,7 @@ bool HardcoreProtester::beBribed() {
     getWorld()->playSound(SOUND_PROTESTER_FOUND_GOLD);
     getWorld()->increaseScore(50);
     int N = std::max(50, 100 - (int)getWorld()->getLevel() * 10);
-    m_ticksToWait = N; // Freeze hardcore
+    setTicksToWait(N); // Freeze hardcore
     return true;
 }
 
@@ -374,12 +430,23 @@ Boulder::Boulder(int startX, int startY, StudentWorld* world)
     world->removeEarth(startX, startY);
 }
 
+void Boulder::saveState(SnapshotWriter& out) const {
+    out.put(m_state);
+    out.put(m_waitingTicks);
+}
+
+void Boulder::loadState(SnapshotReader& in) {
+    m_state = in.get<State>();
+    m_waitingTicks = in.get<int>();
+}
+
 void Boulder::doSomething()
 {
     if (!isAlive()) return;
 
     if (m_state == STABLE) {
         if (!getWorld()->isEarthBelow(getX(), getY())) m_state = WAITING;
+        else getWorld()->sleepUntilDugUnder(this); // nothing can change until that Earth is dug
     }
     else if (m_state == WAITING) {
         m_waitingTicks++;
@@ -391,8 +458,12 @@ void Boulder::doSomething()
     else if (m_state == FALLING) {
         if (getY() > 0 && !getWorld()->isEarthAt(getX(), getY() - 1) &&
             !getWorld()->isBoulderAt(getX(), getY() - 4, 0)) {
+            // Both the vacated and the newly covered locations change accessibility;
+            // neither can be refreshed until the boulder stands on its new row
             moveTo(getX(), getY() - 1);
-            getWorld()->annoyAllNearbyActors(getX(), getY(), 3, 100);
+            getWorld()->flagAreaAsDirty(getX(), getY() + 1, 3);
+            getWorld()->flagAreaAsDirty(getX(), getY(), 3);
+            getWorld()->annoyAllNearbyActors(getX(), getY(), HIT_RADIUS, 100);
         }
         else {
             setDead();
@@ -411,23 +482,30 @@ ActivatableObject::ActivatableObject(int imageID, int startX, int startY, Studen
 
 void ActivatableObject::doSomething()
 {
-    if (!isAlive()) return;
-    if (m_temporary) {
-        m_ticksToLive--;
-        if (m_ticksToLive <= 0) { setDead(); return; }
-    }
-    if (m_pickupableByPlayer) {
-        if (getDistanceTo(getWorld()->getPlayer()) <= 3.0) {
-            setDead();
-            getWorld()->playSound(m_soundID);
-            getWorld()->increaseScore(m_scoreDelta);
-            doEffect();
-            return;
-        }
-        else if (getDistanceTo(getWorld()->getPlayer()) <= 4.0) {
-            setVisible(true);
-        }
-    }
+}
+
+// Score and sound come from the subclass constructor; only what can change is saved
+void ActivatableObject::saveState(SnapshotWriter& out) const {
+    out.put(m_temporary);
+    out.put(m_ticksToLive);
+    out.put(m_pickupableByPlayer);
+    out.put(m_pickupableByEnemy);
+}
+
+void ActivatableObject::loadState(SnapshotReader& in) {
+    m_temporary = in.get<bool>();
+    m_ticksToLive = in.get<int>();
+    m_pickupableByPlayer = in.get<bool>();
+    m_pickupableByEnemy = in.get<bool>();
+}
+
+// Fired by the world's proximity trigger once the player is within PICKUP_RADIUS
+void ActivatableObject::collect()
+{
+    setDead();
+    getWorld()->playSound(m_soundID);
+    getWorld()->increaseScore(m_scoreDelta);
+    doEffect();
 }
 
 Barrel::Barrel(int startX, int startY, StudentWorld* world)
@@ -454,7 +532,6 @@ GoldNugget::GoldNugget(int startX, int startY, StudentWorld* world, bool visible
 void GoldNugget::doEffect() { getWorld()->getPlayer()->addGold(1); }
 
 void GoldNugget::doSomething() {
-    ActivatableObject::doSomething();
     if (!isAlive()) return;
 
     if (isPickupableByEnemy()) {
@@ -466,6 +543,16 @@ Squirt::Squirt(int startX, int startY, StudentWorld* world, Direction dir)
     : Actor(TID_WATER_SPURT, startX, startY, world, dir, 1.0, 0), m_travelDist(4), m_hit(false) {
 }
 
+void Squirt::saveState(SnapshotWriter& out) const {
+    out.put(m_travelDist);
+    out.put(m_hit);
+}
+
+void Squirt::loadState(SnapshotReader& in) {
+    m_travelDist = in.get<int>();
+    m_hit = in.get<bool>();
+}
+
 void Squirt::doSomething() {
     if (m_hit) {
         setDead();
@@ -474,7 +561,7 @@ void Squirt::doSomething() {
 
     if (!isAlive()) return;
 
-    if (getWorld()->annoyProtesters(getX(), getY(), 3, 2)) {
+    if (getWorld()->annoyProtesters(getX(), getY(), HIT_RADIUS, 2)) {
         m_hit = true;
         return;
     }
@@ -2,9 +2,13 @@
 #define ACTOR_H_
 
 #include "GraphObject.h"
+#include "ComponentTable.h"
+#include "Proximity.h"
 #include <algorithm>
 
 class StudentWorld;
+class SnapshotWriter;
+class SnapshotReader;
 
 // ============================================================================
 // BASE ACTOR
@@ -12,12 +16,10 @@ class StudentWorld;
 class Actor : public GraphObject
 {
 public:
-    Actor(int imageID, int startX, int startY, StudentWorld* world, Direction dir = right, double size = 1.0, unsigned int depth = 0)
-        : GraphObject(imageID, startX, startY, dir, size, depth), m_world(world), m_isAlive(true) {
-        setVisible(true);
-    }
+    Actor(int imageID, int startX, int startY, StudentWorld* world, Direction dir = right, double size = 1.0, unsigned int depth = 0);
 
     virtual void doSomething() = 0;
+    virtual void moveTo(int x, int y); // keeps the world's spatial index current
 
     bool isAlive() const { return m_isAlive; }
     void setDead() { m_isAlive = false; }
@@ -29,19 +31,24 @@ public:
     virtual bool isBoulder() const { return false; }
     virtual bool isProtester() const { return false; } // <--- Added for reliable counting
 
-    double getDistanceTo(int x, int y) const;
-    double getDistanceTo(Actor* other) const;
+    int getSquaredDistanceTo(int x, int y) const { return squaredDistance(getX(), getY(), x, y); }
+    bool isWithin(int x, int y, int radius) const { return isWithinRadius(getX(), getY(), x, y, radius); }
+    bool isWithin(const Actor* other, int radius) const { return isWithin(other->getX(), other->getY(), radius); }
+
+    // Which of the world's component tables holds this actor's hot state, and at which row
+    ComponentKind getComponentKind() const { return m_componentKind; }
+    int getComponentRow() const { return m_componentRow; }
+    void setComponentSlot(ComponentKind kind, int row) { m_componentKind = kind; m_componentRow = row; }
+
+    // Class-specific state for world snapshots; the world saves position, direction and visibility
+    virtual void saveState(SnapshotWriter& /* out */) const {}
+    virtual void loadState(SnapshotReader& /* in */) {}
 
 private:
     StudentWorld* m_world;
     bool m_isAlive;
-};
-
-// Earth
-class Earth : public Actor {
-public:
-    Earth(int startX, int startY, StudentWorld* world) : Actor(TID_EARTH, startX, startY, world, right, 0.25, 3) {}
-    virtual void doSomething() {}
+    ComponentKind m_componentKind;
+    int m_componentRow;
 };
 
 // Agent
@@ -54,6 +61,8 @@ public:
     int getHP() const { return m_hp; }
     virtual void decHP(int amount);
     virtual bool canBeAnnoyed() const { return true; }
+    virtual void saveState(SnapshotWriter& out) const;
+    virtual void loadState(SnapshotReader& in);
 
 protected:
     int m_hp;
@@ -72,10 +81,22 @@ public:
     int getSonar() const { return m_sonar; }
     void addWater(int n) { m_water += n; }
     int getWater() const { return m_water; }
+    virtual void saveState(SnapshotWriter& out) const;
+    virtual void loadState(SnapshotReader& in);
 private:
     int m_gold; int m_sonar; int m_water;
 };
 
+// A protester's decision for one tick, worked out only from state no other
+// protester changes during the pass, so the world can plan every due protester at once
+struct ProtesterPlan {
+    enum Action { LEAVE, CONFRONT, TRACK, CHASE, WANDER };
+    Action action;
+    GraphObject::Direction dir; // LEAVE, TRACK, CHASE: the step to take; CONFRONT: the way to turn, if any
+    bool facingPlayer;          // CONFRONT: shout instead of turning
+    unsigned char open;         // WANDER: bit d set when the neighbour in Direction d is accessible
+};
+
 // Protesters
 class Protester : public Agent {
 public:
@@ -86,9 +107,17 @@ public:
     virtual bool isHardcore() const { return false; }
     virtual bool canBeAnnoyed() const;
     virtual bool isProtester() const { return true; } // <--- Override
+    virtual void saveState(SnapshotWriter& out) const;
+    virtual void loadState(SnapshotReader& in);
+
+    int getRestingTicks() const;
+    int getTrackingRange() const; // how far a hardcore protester follows the player field; 0 for the rest
+
+    ProtesterPlan planMove() const;            // reads only; safe to run for many protesters at once
+    void applyMove(const ProtesterPlan& plan); // the writes and random draws, one protester at a time
 
 protected:
-    int m_ticksToWait;
+    void setTicksToWait(int ticks); // the rest countdown itself lives in the world's protester table
     int m_stunTicks;
 
 private:
@@ -99,7 +128,8 @@ private:
 
     bool isFacingPlayer() const;
     bool hasLineOfSightToPlayer() const;
-    void pickNewDirection();
+    void pickNewDirection(unsigned char open);
+    void step(Direction dir);
 };
 
 class RegularProtester : public Protester {
@@ -120,6 +150,8 @@ public:
     Boulder(int startX, int startY, StudentWorld* world);
     virtual void doSomething();
     virtual bool isBoulder() const { return true; }
+    virtual void saveState(SnapshotWriter& out) const;
+    virtual void loadState(SnapshotReader& in);
 private:
     enum State { STABLE, WAITING, FALLING };
     State m_state; int m_waitingTicks;
@@ -129,12 +161,17 @@ private:
 class ActivatableObject : public Actor {
 public:
     ActivatableObject(int imageID, int startX, int startY, StudentWorld* world, int score, int sound, bool startsVisible, bool temporary, int ticksToLive = 0);
-    virtual void doSomething();
+    virtual void doSomething(); // lifetimes and player pickups are driven by the world's timers and triggers
     virtual void doEffect() = 0;
+    void collect();
+    bool isTemporary() const { return m_temporary; }
+    int getLifetime() const { return m_ticksToLive; }
     bool isPickupableByPlayer() const { return m_pickupableByPlayer; }
     void setPickupableByPlayer(bool val) { m_pickupableByPlayer = val; }
     bool isPickupableByEnemy() const { return m_pickupableByEnemy; }
     void setPickupableByEnemy(bool val) { m_pickupableByEnemy = val; }
+    virtual void saveState(SnapshotWriter& out) const;
+    virtual void loadState(SnapshotReader& in);
 private:
     int m_scoreDelta; int m_soundID; bool m_temporary; int m_ticksToLive; bool m_pickupableByPlayer; bool m_pickupableByEnemy;
 };
@@ -149,6 +186,8 @@ class Squirt : public Actor {
 public:
     Squirt(int startX, int startY, StudentWorld* world, Direction dir);
     virtual void doSomething();
+    virtual void saveState(SnapshotWriter& out) const;
+    virtual void loadState(SnapshotReader& in);
 private:
     int m_travelDist;
     bool m_hit;
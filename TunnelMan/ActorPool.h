@@ -0,0 +1,94 @@
+#ifndef ACTORPOOL_H_
+#define ACTORPOOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// ============================================================================
+// ACTOR POOL
+// Level-scoped allocator for actors. Requests are rounded up to 64-byte size
+// classes and served from per-class free lists carved out of 64-slot chunks.
+// reset() hands every slot back at once but keeps the chunks, so later levels
+// allocate nothing from the heap until they outgrow the earlier ones.
+// ============================================================================
+class ActorPool
+{
+public:
+    ActorPool() {
+        for (int c = 0; c < NUM_CLASSES; c++) m_free[c] = nullptr;
+    }
+
+    ~ActorPool() {
+        for (Chunk& chunk : m_chunks) ::operator delete(chunk.memory);
+    }
+
+    void* allocate(size_t size) {
+        size_t cls = (size + HEADER + CLASS_STEP - 1) / CLASS_STEP - 1;
+        if (cls >= NUM_CLASSES) {
+            // Too big for any class; fall back to the heap but keep the header layout
+            unsigned char* slot = static_cast<unsigned char*>(::operator new(size + HEADER));
+            slot[0] = OVERSIZE;
+            return slot + HEADER;
+        }
+        if (m_free[cls] == nullptr) grow(cls);
+
+        FreeSlot* slot = m_free[cls];
+        m_free[cls] = slot->next;
+        reinterpret_cast<unsigned char*>(slot)[0] = static_cast<unsigned char>(cls);
+        return reinterpret_cast<unsigned char*>(slot) + HEADER;
+    }
+
+    void deallocate(void* p) {
+        unsigned char* slot = static_cast<unsigned char*>(p) - HEADER;
+        if (slot[0] == OVERSIZE) {
+            ::operator delete(slot);
+            return;
+        }
+        unsigned char cls = slot[0];
+        FreeSlot* free = reinterpret_cast<FreeSlot*>(slot);
+        free->next = m_free[cls];
+        m_free[cls] = free;
+    }
+
+    // Every object must already have been destroyed
+    void reset() {
+        for (int c = 0; c < NUM_CLASSES; c++) m_free[c] = nullptr;
+        for (Chunk& chunk : m_chunks) threadChunk(chunk);
+    }
+
+    size_t getChunkCount() const { return m_chunks.size(); }
+
+private:
+    static const size_t HEADER = alignof(std::max_align_t); // holds the slot's size class
+    static const size_t CLASS_STEP = 64;
+    static const int NUM_CLASSES = 8;
+    static const size_t SLOTS_PER_CHUNK = 64;
+    static const unsigned char OVERSIZE = 0xFF;
+
+    struct FreeSlot { FreeSlot* next; };
+    struct Chunk { unsigned char* memory; size_t cls; };
+
+    FreeSlot* m_free[NUM_CLASSES];
+    std::vector<Chunk> m_chunks;
+
+    static size_t slotSize(size_t cls) { return (cls + 1) * CLASS_STEP; }
+
+    void grow(size_t cls) {
+        Chunk chunk = { static_cast<unsigned char*>(::operator new(slotSize(cls) * SLOTS_PER_CHUNK)), cls };
+        m_chunks.push_back(chunk);
+        threadChunk(chunk);
+    }
+
+    // Pushes all of a chunk's slots onto its class's free list
+    void threadChunk(const Chunk& chunk) {
+        for (size_t k = SLOTS_PER_CHUNK; k-- > 0; ) {
+            FreeSlot* slot = reinterpret_cast<FreeSlot*>(chunk.memory + k * slotSize(chunk.cls));
+            slot->next = m_free[chunk.cls];
+            m_free[chunk.cls] = slot;
+        }
+    }
+};
+
+#endif // ACTORPOOL_H_
@@ -0,0 +1,73 @@
+#ifndef COMPONENTTABLE_H_
+#define COMPONENTTABLE_H_
+
+#include <vector>
+#include <cstddef>
+
+enum ComponentKind { NO_COMPONENTS, PROTESTER_COMPONENTS, BOULDER_COMPONENTS, PICKUP_COMPONENTS, SQUIRT_COMPONENTS };
+
+// ============================================================================
+// COMPONENT TABLE
+// Structure-of-arrays storage for one kind of actor. Row i of every column
+// belongs to owner[i]. StudentWorld's per-kind update passes scan the columns
+// and only touch an actor object when its row says there is work to do.
+// ============================================================================
+template <typename T>
+class ComponentTable
+{
+public:
+    std::vector<T*> owner;
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<int> timer;           // meaning depends on the kind: rest ticks, lifetime, ...
+    std::vector<unsigned char> flags;
+
+    explicit ComponentTable(ComponentKind kind) : m_kind(kind) {}
+
+    size_t size() const { return owner.size(); }
+
+    void clear() {
+        owner.clear();
+        x.clear();
+        y.clear();
+        timer.clear();
+        flags.clear();
+    }
+
+    void add(T* actor, int timerValue, unsigned char flagBits) {
+        actor->setComponentSlot(m_kind, static_cast<int>(owner.size()));
+        owner.push_back(actor);
+        x.push_back(actor->getX());
+        y.push_back(actor->getY());
+        timer.push_back(timerValue);
+        flags.push_back(flagBits);
+    }
+
+    // Drops the rows whose owner satisfies isDead, keeping the others in order
+    template <typename Dead>
+    void reap(Dead isDead) {
+        size_t kept = 0;
+        for (size_t i = 0; i < owner.size(); i++) {
+            if (isDead(owner[i])) continue;
+            if (kept != i) {
+                owner[kept] = owner[i];
+                x[kept] = x[i];
+                y[kept] = y[i];
+                timer[kept] = timer[i];
+                flags[kept] = flags[i];
+                owner[kept]->setComponentSlot(m_kind, static_cast<int>(kept));
+            }
+            kept++;
+        }
+        owner.resize(kept);
+        x.resize(kept);
+        y.resize(kept);
+        timer.resize(kept);
+        flags.resize(kept);
+    }
+
+private:
+    ComponentKind m_kind;
+};
+
+#endif // COMPONENTTABLE_H_
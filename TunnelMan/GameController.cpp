@@ -5,11 +5,14 @@
 #include "GraphObject.h"
 #include "SoundFX.h"
 #include "SpriteManager.h"
+#include "Terrain.h"
 #include <string>
 #include <map>
 #include <utility>
 #include <cstdlib>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 using namespace std;
 
 /*
@@ -48,7 +51,14 @@ static const double FONT_SCALEDOWN = 760.0;
 static const double SCORE_Y = 3.8;
 static const double SCORE_Z = -10;
 
-static const int MS_PER_FRAME = 1;
+static const double DEFAULT_TICKS_PER_SECOND = 30;	// the pace the frame-locked loop kept on a 60 Hz display
+static const double FRAMES_PER_SECOND = 60;
+static const double MAX_CATCH_UP_SECONDS = 0.25;	// after a stall, drop time rather than run a burst of ticks
+
+static const int REWIND_SCRUB_TICKS = 30;	// about a second of play per press
+
+static const int EARTH_LAYER = 3;
+static const double EARTH_SIZE = 0.25;
 
 static const double PI = 4 * atan(1.0);
 
@@ -61,7 +71,7 @@ struct SpriteInfo
 
 static void convertToGlutCoords(double x, double y, double& gx, double& gy, double& gz);
 static void drawPrompt(string mainMessage, string secondMessage);
-static void drawScoreAndLives(string);
+static void drawScoreAndLives(string, Random&);
 
 void GameController::initDrawersAndSounds()
 {
@@ -140,20 +150,39 @@ static void specialKeyboardEventCallback(int key, int x, int y)
 	Game().specialKeyboardEvent(key, x, y);
 }
 
+static double secondsNow()
+{
+	return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+  // One frame per call; GLUT sleeps in its event loop until the next one is due
 static void timerFuncCallback(int val)
 {
 	Game().doSomething();
-	glutTimerFunc(MS_PER_FRAME, timerFuncCallback, 0);
+	glutTimerFunc(Game().getMsUntilNextFrame(), timerFuncCallback, 0);
+}
+
+int GameController::getMsUntilNextFrame() const
+{
+	double wait = m_lastFrameTime + 1 / FRAMES_PER_SECOND - secondsNow();
+	return wait > 0 ? static_cast<int>(ceil(wait * 1000)) : 0;
 }
 
 void GameController::run(int argc, char* argv[], GameWorld* gw, string windowTitle)
 {
-	gw->setController(this);
+	InputRecorder recorder(*this, m_inputLog);
+	m_recorder = m_recordPath.empty() ? nullptr : &recorder;
+	gw->setController(m_recorder != nullptr ? static_cast<GameHost*>(m_recorder) : this);
+	gw->setRewindEnabled(m_recorder == nullptr);	// a log of a rewound session would not replay
 	m_gw = gw;
 	setGameState(welcome);
 	m_lastKeyHit = INVALID_KEY;
 	m_singleStep = false;
-	m_curIntraFrameTick = 0;
+	m_rewindRequest = 0;
+	if (m_tickSeconds <= 0)
+		m_tickSeconds = 1 / DEFAULT_TICKS_PER_SECOND;
+	m_accumulator = 0;
+	m_lastFrameTime = secondsNow();
 	m_playerWon = false;
 
 	glutInit(&argc, argv);
@@ -169,10 +198,12 @@ void GameController::run(int argc, char* argv[], GameWorld* gw, string windowTit
 	glutSpecialFunc(specialKeyboardEventCallback);
 	glutReshapeFunc(reshapeCallback);
 	glutDisplayFunc(doSomethingCallback);
-	glutTimerFunc(MS_PER_FRAME, timerFuncCallback, 0);
+	glutTimerFunc(0, timerFuncCallback, 0);
 
 	glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
 	glutMainLoop();
+	if (m_recorder != nullptr && !m_inputLog.save(m_recordPath))
+		cerr << "Cannot write input log " << m_recordPath << endl;
 	delete m_gw;
 }
 
@@ -187,6 +218,9 @@ void GameController::keyboardEvent(unsigned char key, int /* x */, int /* y */)
 		case 't':			m_lastKeyHit = KEY_PRESS_TAB;	break;
 		case 'f':			m_singleStep = true;			break;
 		case 'r':			m_singleStep = false;			break;
+		case 'b':			m_rewindRequest += 1;
+							m_singleStep = true;			break;	// step back one tick and hold there
+		case 'v':			m_rewindRequest += REWIND_SCRUB_TICKS; break;
 		case 'q': case 'Q': setGameState(quit);				break;
 		default:			m_lastKeyHit = key;				break;
 	}
@@ -221,6 +255,10 @@ void GameController::playSound(int soundID)
 
 void GameController::doSomething()
 {
+	double now = secondsNow();
+	double elapsed = min(now - m_lastFrameTime, MAX_CATCH_UP_SECONDS);
+	m_lastFrameTime = now;
+
 	switch (m_gameState)
 	{
 		case not_applicable:
@@ -229,53 +267,32 @@ void GameController::doSomething()
 			playSound(SOUND_THEME);
 			m_mainMessage = "Welcome to TunnelMan!";
 			m_secondMessage = "Press Enter to begin play...";
+			m_gw->prepareNextLevel();	// built while the prompt is up; init() swaps it in
 			setGameState(prompt);
 			m_nextStateAfterPrompt = init;
 			break;
 		case contgame:
 			m_mainMessage = "You lost a life!";
 			m_secondMessage = "Press Enter to continue playing...";
+			m_gw->prepareNextLevel();
 			setGameState(prompt);
 			m_nextStateAfterPrompt = cleanup;
 			break;
 		case finishedlevel:
 			m_mainMessage = "Woot! You finished the level!";
 			m_secondMessage = "Press Enter to continue playing...";
+			m_gw->prepareNextLevel();
 			setGameState(prompt);
 			m_nextStateAfterPrompt = cleanup;
 			break;
 		case makemove:
-			m_curIntraFrameTick = ANIMATION_POSITIONS_PER_TICK;
-			m_nextStateAfterAnimate = not_applicable;
-			{
-				int status = m_gw->move();
-				if (status == GWSTATUS_PLAYER_DIED)
-				{
-					  // animate one last frame so the player can see what happened
-					m_nextStateAfterAnimate = (m_gw->isGameOver() ? gameover : contgame);
-				}
-				else if (status == GWSTATUS_FINISHED_LEVEL)
-				{
-					m_gw->advanceToNextLevel();
-					  // animate one last frame so the player can see what happened
-					m_nextStateAfterAnimate = finishedlevel;
-				}
-			}
-			setGameState(animate);
+			advanceSimulation(elapsed);
 			break;
 		case animate:
-			displayGamePlay();
-			if (m_curIntraFrameTick-- <= 0)
-			{
-				if (m_nextStateAfterAnimate != not_applicable)
-					setGameState(m_nextStateAfterAnimate);
-				else
-				{
-					int key;
-					if (!m_singleStep  ||  getLastKey(key))
-						setGameState(makemove);
-				}
-			}
+			  // show the level's last tick once so the player can see what happened
+			displayGamePlay(1);
+			m_rewindRequest = 0;	// the level is over; there is nothing to go back into
+			setGameState(m_nextStateAfterAnimate);
 			break;
 		case cleanup:
 			m_gw->cleanUp();
@@ -317,7 +334,10 @@ void GameController::doSomething()
 					m_nextStateAfterPrompt = quit;
 				}
 				else
+				{
+					m_accumulator = 0;	// the prompt's time is not owed to the new level
 					setGameState(makemove);
+				}
 			}
 			break;
 		case quit:
@@ -362,7 +382,82 @@ void GameController::drawEarth(double gx, double gy, double gz, double size)
 
 }
 
-void GameController::displayGamePlay()
+void GameController::displayTerrain()
+{
+	const Terrain* terrain = m_gw->getTerrain();
+	if (terrain == nullptr)
+		return;
+
+	for (int y = 0; y < VIEW_HEIGHT; y++)
+	{
+		uint64_t row = terrain->getRow(y);
+		for (int x = 0; row != 0; x++, row >>= 1)
+		{
+			if (row & 1)
+			{
+				double gx, gy, gz;
+				convertToGlutCoords(x, y, gx, gy, gz);
+				drawEarth(gx, gy, gz, EARTH_SIZE);
+			}
+		}
+	}
+}
+
+  // Runs as many ticks as the real time since the last frame pays for, then
+  // draws the world part way from the last tick to the one after it
+void GameController::advanceSimulation(double elapsed)
+{
+	if (m_rewindRequest > 0)
+	{
+		m_gw->rewind(m_rewindRequest);
+		m_gw->getGraphObjects().beginTick();	// no motion to blend across a jump back
+		m_rewindRequest = 0;
+		m_accumulator = 0;
+	}
+
+	if (m_singleStep)
+	{
+		int key;
+		m_accumulator = 0;
+		if (getLastKey(key)  &&  !runTick())
+			return;
+		displayGamePlay(1);
+		return;
+	}
+
+	m_accumulator += elapsed;
+	while (m_accumulator >= m_tickSeconds)
+	{
+		m_accumulator -= m_tickSeconds;
+		if (!runTick())
+			return;
+	}
+	displayGamePlay(m_accumulator / m_tickSeconds);
+}
+
+  // Returns false when the tick ended the level and the animate state has been set
+bool GameController::runTick()
+{
+	m_gw->getGraphObjects().beginTick();
+	if (m_recorder != nullptr)
+		m_recorder->startTick();
+
+	int status = m_gw->move();
+	if (status == GWSTATUS_PLAYER_DIED)
+		m_nextStateAfterAnimate = (m_gw->isGameOver() ? gameover : contgame);
+	else if (status == GWSTATUS_FINISHED_LEVEL)
+	{
+		m_gw->advanceToNextLevel();
+		m_nextStateAfterAnimate = finishedlevel;
+	}
+	else
+		return true;
+
+	setGameState(animate);
+	return false;
+}
+
+void GameController::displayGamePlay(double alpha)
 {
 	glEnable(GL_DEPTH_TEST); // must be done each time before displaying graphics or gets disabled for some reason
 	glLoadIdentity();
@@ -371,17 +466,18 @@ void GameController::displayGamePlay()
 
 	for (int i = NUM_LAYERS - 1; i >= 0; --i)
 	{
-		std::set<GraphObject*> &graphObjects = GraphObject::getGraphObjects(i);
+		if (i == EARTH_LAYER)
+			displayTerrain();
 
-		for (auto it = graphObjects.begin(); it != graphObjects.end(); it++)
+		const std::vector<GraphObject*> &graphObjects = m_gw->getGraphObjects().getGraphObjects(i);
+
+		for (size_t k = 0; k < graphObjects.size(); k++)
 		{
-			GraphObject* cur = *it;
+			GraphObject* cur = graphObjects[k];
 			if (cur->isVisible())
 			{
-				cur->animate();
-
 				double x, y, gx, gy, gz;
-				cur->getAnimationLocation(x, y);
+				cur->getAnimationLocation(alpha, x, y);
 				convertToGlutCoords(x, y, gx, gy, gz);
 
 				SpriteManager::Angle angle;
@@ -405,16 +501,12 @@ void GameController::displayGamePlay()
 
 				int imageID = cur->getID();
 
-				// the specialized Earth plotting is an optimization to deal with the background Earth, which requires a lot of horsepower to plot
-				if (imageID == TID_EARTH)
-					drawEarth(gx, gy, gz, cur->getSize());
-				else
-					m_spriteManager.plotSprite(imageID, cur->getAnimationNumber() % m_spriteManager.getNumFrames(imageID), gx, gy, gz, angle, cur->getSize());
+				m_spriteManager.plotSprite(imageID, cur->getAnimationNumber() % m_spriteManager.getNumFrames(imageID), gx, gy, gz, angle, cur->getSize());
 			}
 		}
 	}
 
-	drawScoreAndLives(m_gameStatText);
+	drawScoreAndLives(m_gameStatText, m_cosmeticRandom);
 
 	glutSwapBuffers();
 }
@@ -476,14 +568,14 @@ static void drawPrompt(string mainMessage, string secondMessage)
 	glutSwapBuffers();
 }
 
-static void drawScoreAndLives(string gameStatText)
+static void drawScoreAndLives(string gameStatText, Random& random)
 {
 	static int RATE = 1;
 	static GLfloat rgb[3] =
 		{ static_cast<GLfloat>(.6), static_cast<GLfloat>(.6), static_cast<GLfloat>(.6) };
 	for (int k = 0; k < 3; k++)
 	{
-		double strength = rgb[k] + (-RATE + rand() % (2*RATE+1)) / 100.0;
+		double strength = rgb[k] + (-RATE + random.nextInt(2*RATE+1)) / 100.0;
 		if (strength < .6)
 			strength = .6;
 		else if (strength > 1.0)
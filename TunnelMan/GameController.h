@@ -2,6 +2,9 @@
 #define GAMECONTROLLER_H_
 
 #include "SpriteManager.h"
+#include "GameWorld.h"
+#include "Random.h"
+#include "InputLog.h"
 #include <string>
 #include <map>
 #include <iostream>
@@ -14,14 +17,32 @@ enum GameControllerState {
 const int INVALID_KEY = 0;
 
 class GraphObject;
-class GameWorld;
 
-class GameController
+class GameController : public GameHost
 {
   public:
 	void run(int argc, char* argv[], GameWorld* gw, std::string windowTitle);
 
-	bool getLastKey(int& value)
+	  // Logs every key the world reads, to be written to path when the game
+	  // exits; seed must be the one the world was given. Call before run().
+	void recordInput(std::string path, uint64_t seed)
+	{
+		m_recordPath = path;
+		m_inputLog.reset(seed);
+	}
+
+	  // How many times a second the world's move() runs, whatever the frame
+	  // rate; call before run() to change the default
+	void setTickRate(double ticksPerSecond)
+	{
+		if (ticksPerSecond > 0)
+			m_tickSeconds = 1 / ticksPerSecond;
+	}
+
+	  // How long the main loop can sleep before the next frame is due
+	int getMsUntilNextFrame() const;
+
+	virtual bool getLastKey(int& value)
 	{
 		if (m_lastKeyHit != INVALID_KEY)
 		{
@@ -32,9 +53,9 @@ class GameController
 		return false;
 	}
 
-	void playSound(int soundID);
+	virtual void playSound(int soundID);
 
-	void setGameStatText(std::string text)
+	virtual void setGameStatText(std::string text)
 	{
 		m_gameStatText = text;
 	}
@@ -45,7 +66,7 @@ class GameController
 	void keyboardEvent(unsigned char key, int x, int y);
 	void specialKeyboardEvent(int key, int x, int y);
 
-	void quitGame()
+	virtual void quitGame()
 	{
 		setGameState(quit);
 	}
@@ -64,15 +85,22 @@ private:
 	GameControllerState	m_nextStateAfterAnimate;
 	int			m_lastKeyHit;
 	bool		m_singleStep;
+	int			m_rewindRequest;	// ticks to step back before the next move
 	std::string m_gameStatText;
 	std::string m_mainMessage;
 	std::string m_secondMessage;
-	int			m_curIntraFrameTick;
+	double		m_tickSeconds;		// simulated time per move(); zero until set (static storage)
+	double		m_accumulator;		// real time owed to the simulation, less than one tick after a frame
+	double		m_lastFrameTime;	// seconds on the steady clock
 	typedef std::map<int, std::string> SoundMapType;
 	typedef std::map<int, std::string> DrawMapType;
 	SoundMapType m_soundMap;
 	bool		m_playerWon;
 	SpriteManager m_spriteManager;
+	Random		m_cosmeticRandom;	// kept apart from the world's stream so drawing never changes gameplay
+	std::string m_recordPath;
+	InputLog	m_inputLog;
+	InputRecorder* m_recorder;		// sits between the world and this controller while recording
 
 	void setGameState(GameControllerState s)
 	{
@@ -81,7 +109,10 @@ private:
 	}
 
 	void initDrawersAndSounds();
-	void displayGamePlay();
+	void advanceSimulation(double elapsed);
+	bool runTick();
+	void displayGamePlay(double alpha);
+	void displayTerrain();	// Earth comes from the world's bitmap, not from GraphObjects
 	void drawEarth(double gx, double gy, double gz, double size);	// optimized - does not use sprite engine
 };
 
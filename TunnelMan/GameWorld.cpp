@@ -1,5 +1,4 @@
 #include "GameWorld.h"
-#include "GameController.h"
 #include <string>
 #include <cstdlib>
 using namespace std;
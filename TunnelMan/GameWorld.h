@@ -2,11 +2,38 @@
 #define GAMEWORLD_H_
 
 #include "GameConstants.h"
+#include "GraphObject.h"
 #include <string>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
 
 const int START_PLAYER_LIVES = 3;
 
-class GameController;
+class Terrain;
+
+  // How much history GameWorld::rewind() has to work with
+struct RewindStats
+{
+	size_t	ticks;				// how many ticks back rewind() can currently go
+	size_t	bytes;				// history memory in use
+	size_t	budget;				// the most it will ever use
+	double	lastRewindSeconds;	// how long the last rewind() took
+};
+
+  // What a world needs from whatever drives it: the GLUT GameController or a headless driver
+class GameHost
+{
+public:
+	virtual ~GameHost()
+	{
+	}
+
+	virtual bool getLastKey(int& value) = 0;
+	virtual void playSound(int soundID) = 0;
+	virtual void setGameStatText(std::string text) = 0;
+	virtual void quitGame() = 0;
+};
 
 class GameWorld
 {
@@ -73,7 +100,7 @@ public:
 		++m_level;
 	}
    
-	void setController(GameController* controller)
+	void setController(GameHost* controller)
 	{
 		m_controller = controller;
 	}
@@ -82,13 +109,107 @@ public:
 	{
 		return m_assetDir;
 	}
+
+	GraphObjectRegistry& getGraphObjects()
+	{
+		return m_graphObjects;
+	}
+
+	  // Seeds the world's own random stream; a given seed replays the same game
+	virtual void setSeed(uint64_t /* seed */)
+	{
+	}
+
+	  // Earth bitmap drawn by the renderer in place of per-cell objects
+	virtual const Terrain* getTerrain() const
+	{
+		return nullptr;
+	}
+
+	  // Wall-clock time the last init() took: how long the level transition stalled
+	virtual double getGenerationSeconds() const
+	{
+		return 0;
+	}
+
+	  // Player distance floods run for hardcore protesters since the world was
+	  // made, and those avoided because the shared field was still current
+	virtual unsigned long getPlayerBFSRuns() const
+	{
+		return 0;
+	}
+
+	virtual unsigned long getPlayerBFSRunsSaved() const
+	{
+		return 0;
+	}
+
+	  // Starts building the level the next init() will use on a worker thread,
+	  // e.g. while a prompt is on screen. Call only after the move() that ended
+	  // a level (or before the first init()) and before the following init().
+	virtual void prepareNextLevel()
+	{
+	}
+
+	  // Blocks until the level started by prepareNextLevel() is ready
+	virtual void finishPreparingLevel()
+	{
+	}
+
+	  // Writes the whole game state into out; only valid between ticks.
+	  // Returns false if the world has nothing to save.
+	virtual bool saveSnapshot(std::vector<unsigned char>& /* out */) const
+	{
+		return false;
+	}
+
+	  // Replaces the current level with one saved by saveSnapshot() in this build.
+	  // On false the level has been cleaned up and needs a fresh init().
+	virtual bool restoreSnapshot(const std::vector<unsigned char>& /* in */)
+	{
+		return false;
+	}
+
+	  // Lets the world plan protesters on up to this many threads when there are
+	  // enough of them; results are the same for any count
+	virtual void setProtesterThreads(int /* threads */)
+	{
+	}
+
+	  // Keeps the current level's recent ticks for rewind(); off until enabled
+	virtual void setRewindEnabled(bool /* enabled */)
+	{
+	}
+
+	  // Steps back up to `ticks` ticks, as far as the history reaches, and
+	  // returns how many it went. Only between ticks, within the current level.
+	virtual int rewind(int /* ticks */)
+	{
+		return 0;
+	}
+
+	virtual RewindStats getRewindStats() const
+	{
+		RewindStats none = { 0, 0, 0, 0 };
+		return none;
+	}
+
+protected:
+	  // Puts back the counters a snapshot carries
+	void setProgress(unsigned int lives, unsigned int score, unsigned int level)
+	{
+		m_lives = lives;
+		m_score = score;
+		m_level = level;
+	}
 	
 private:
 	unsigned int	m_lives;
 	unsigned int	m_score;
 	unsigned int	m_level;
-	GameController* m_controller;
+	GameHost*		m_controller;
 	std::string		m_assetDir;
+	GraphObjectRegistry m_graphObjects;
 };
 
 #endif // GAMEWORLD_H_
@@ -1,13 +1,11 @@
 #ifndef GRAPHOBJ_H_
 #define GRAPHOBJ_H_
 
-#include "SpriteManager.h"
 #include "GameConstants.h"
 
-#include <set>
+#include <vector>
 #include <cmath>
 
-const int ANIMATION_POSITIONS_PER_TICK = 1;
 const int NUM_LAYERS = 4;
 
 inline int roundAwayFromZero(double r)
@@ -17,26 +15,60 @@ inline int roundAwayFromZero(double r)
 	 // If C99 is available, this can be return std::round(r);
 }
 
+class GraphObject;
+
+  // The GraphObjects of one world, grouped by depth layer; each world owns its own.
+  // Each layer is a dense array: objects remember their slot, so adding and
+  // removing are O(1) (removal swaps the last object into the hole).
+class GraphObjectRegistry
+{
+  public:
+
+	const std::vector<GraphObject*>& getGraphObjects(unsigned int layer) const
+	{
+		if (layer < NUM_LAYERS)
+			return m_graphObjects[layer];
+		else
+			return m_graphObjects[0];		// empty;
+	}
+
+	void add(GraphObject* obj);
+	void remove(GraphObject* obj);
+
+	  // Called before each tick (and after anything that teleports objects) so
+	  // drawing interpolates from where everything is now
+	void beginTick();
+
+  private:
+	std::vector<GraphObject*> m_graphObjects[NUM_LAYERS];
+
+	std::vector<GraphObject*>& layerOf(const GraphObject* obj);
+};
+
 class GraphObject
 {
   public:
 
 	enum Direction { none, up, down, left, right };
 
-	GraphObject(int imageID, int startX, int startY, Direction dir = right, double size = 1.0, unsigned int depth = 0)
+	GraphObject(int imageID, int startX, int startY, Direction dir = right, double size = 1.0, unsigned int depth = 0,
+				GraphObjectRegistry* registry = nullptr)
 	 : m_imageID(imageID), m_visible(false), m_x(startX), m_y(startY),
 	   m_destX(startX), m_destY(startY), m_brightness(1.0),
-	   m_animationNumber(0), m_direction(dir), m_size(size), m_depth(depth)
+	   m_animationNumber(0), m_direction(dir), m_size(size), m_depth(depth),
+	   m_registry(registry), m_registrySlot(0)
 	{
 		if (m_size <= 0)
 			m_size = 1;
 
-		getGraphObjects(m_depth).insert(this);
+		if (m_registry != nullptr)
+			m_registry->add(this);
 	}
 
 	virtual ~GraphObject()
 	{
-		getGraphObjects(m_depth).erase(this);
+		if (m_registry != nullptr)
+			m_registry->remove(this);
 	}
 
 	void setVisible(bool shouldIDisplay)
@@ -61,7 +93,7 @@ class GraphObject
 		return roundAwayFromZero(m_destY);
 	}
 
-	void moveTo(int x, int y)
+	virtual void moveTo(int x, int y)
 	{
 		m_destX = x;
 		m_destY = y;
@@ -105,26 +137,12 @@ class GraphObject
 		return m_animationNumber;
 	}
 
-	void getAnimationLocation(double& x, double& y) const
-	{
-		x = m_x;
-		y = m_y;
-	}
-
-	void animate()
-	{
-		// m_animationNumber++;
-		moveALittle(m_x, m_destX);
-		moveALittle(m_y, m_destY);
-	}
-
-	static std::set<GraphObject*>& getGraphObjects(unsigned int layer)
+	  // Where to draw the object `alpha` of the way (0 to 1) from where it was
+	  // when the tick began to where the tick left it
+	void getAnimationLocation(double alpha, double& x, double& y) const
 	{
-		static std::set<GraphObject*> graphObjects[NUM_LAYERS];
-		if (layer < NUM_LAYERS)
-			return graphObjects[layer];
-		else
-			return graphObjects[0];		// empty;
+		x = m_x + (m_destX - m_x) * alpha;
+		y = m_y + (m_destY - m_y) * alpha;
 	}
 
   private:
@@ -134,7 +152,7 @@ class GraphObject
 
 	int		m_imageID;
 	bool	m_visible;
-	double	m_x;
+	double	m_x;		// location at the start of the current tick
 	double	m_y;
 	double	m_destX;
 	double	m_destY;
@@ -143,17 +161,10 @@ class GraphObject
 	Direction	m_direction;
 	double	m_size;
 	int		m_depth;
+	GraphObjectRegistry* m_registry;
+	size_t	m_registrySlot;		// index within m_registry's layer
 
-	void moveALittle(double& from, double& to)
-	{
-		static const double DISTANCE = 1.0/ANIMATION_POSITIONS_PER_TICK;
-		if (to - from >= DISTANCE)
-			from += DISTANCE;
-		else if (from - to >= DISTANCE)
-			from -= DISTANCE;
-		else
-			from = to;
-	}
+	friend class GraphObjectRegistry;
 
 	void increaseAnimationNumber()
 	{
@@ -161,4 +172,38 @@ class GraphObject
 	}
 };
 
+inline std::vector<GraphObject*>& GraphObjectRegistry::layerOf(const GraphObject* obj)
+{
+	unsigned int layer = static_cast<unsigned int>(obj->m_depth);
+	return m_graphObjects[layer < NUM_LAYERS ? layer : 0];
+}
+
+inline void GraphObjectRegistry::add(GraphObject* obj)
+{
+	std::vector<GraphObject*>& objects = layerOf(obj);
+	obj->m_registrySlot = objects.size();
+	objects.push_back(obj);
+}
+
+inline void GraphObjectRegistry::remove(GraphObject* obj)
+{
+	std::vector<GraphObject*>& objects = layerOf(obj);
+	GraphObject* last = objects.back();
+	objects[obj->m_registrySlot] = last;
+	last->m_registrySlot = obj->m_registrySlot;
+	objects.pop_back();
+}
+
+inline void GraphObjectRegistry::beginTick()
+{
+	for (int layer = 0; layer < NUM_LAYERS; layer++)
+	{
+		for (GraphObject* obj : m_graphObjects[layer])
+		{
+			obj->m_x = obj->m_destX;
+			obj->m_y = obj->m_destY;
+		}
+	}
+}
+
 #endif // GRAPHOBJ_H_
@@ -0,0 +1,700 @@
+// Runs StudentWorld without GLUT, a window or sound, for load testing and profiling.
+//
+//   TunnelManHeadless [--ticks N] [--levels N] [--seed N] [--prefetch] [--protester-threads N]
+//   TunnelManHeadless --worlds N [--threads N] [--ticks N] [--levels N] [--seed N] [--per-world] [--prefetch]
+//   TunnelManHeadless --check-snapshots N [--ticks N] [--seed N] [--seeds N]
+//   TunnelManHeadless --check-rewind N [--ticks N] [--seed N]
+//   TunnelManHeadless --record FILE [--ticks N] [--levels N] [--seed N]
+//   TunnelManHeadless --replay FILE
+//   TunnelManHeadless --bench-reap N
+//
+// A scripted player wanders, digs, squirts and drops gold so the world sees
+// a realistic mix of work. The first form plays back-to-back games until N
+// ticks or N finished levels, whichever comes first, and prints the tick
+// throughput. The second plays N independent worlds (one game each, capped
+// by --ticks/--levels) on a thread pool and aggregates their throughput and
+// outcomes. The third plays one game, snapshotting the world every tick, and
+// every N ticks restores the snapshot into a second world that plays the next
+// N ticks alongside the first; it reports the snapshot cost and any tick where
+// the two diverge; --seeds N repeats that for N games from consecutive seeds
+// and totals them. --check-rewind plays one game with rewind on and every N
+// ticks steps a random distance back, checking the world against the state
+// it really had then; it reports history size and rewind latency. --record plays one game as the first form would and
+// writes the keys the world read to FILE; --replay plays a log written by
+// either this or TunnelMan --record back as fast as it will go and prints the
+// same per-game checksum. The last form times the dead-actor reaping
+// strategies on a list of N short-lived entries.
+//
+// Both game modes report the init stall, the time each init() took. With
+// --prefetch every level is built in the background first, as the game does
+// while its prompt is up, so the stall left is only swapping the level in.
+// Checksums must come out the same either way. --protester-threads lets the
+// first form's world plan large protester crowds on that many threads, which
+// must not change the checksum either. The first form also reports how many
+// player-field floods hardcore protesters ran and how many sharing saved.
+
+#include "GameWorld.h"
+#include "GameConstants.h"
+#include "Reaping.h"
+#include "InputLog.h"
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+using namespace std;
+
+GameWorld* createStudentWorld(string assetDir = "");
+
+class HeadlessHost : public GameHost
+{
+  public:
+	HeadlessHost(unsigned int seed)
+	 : m_state(seed * 2654435761u + 1), m_heldKey(KEY_PRESS_RIGHT), m_quit(false)
+	{
+	}
+
+	virtual bool getLastKey(int& value)
+	{
+		unsigned int r = next();
+		if (r % 3 == 0)
+			return false;
+		if (r % 16 == 1)
+		{
+			static const int moves[] = { KEY_PRESS_LEFT, KEY_PRESS_RIGHT, KEY_PRESS_UP, KEY_PRESS_DOWN };
+			m_heldKey = moves[(r >> 8) % 4];
+		}
+		switch (r % 41)
+		{
+			case 0:	 value = KEY_PRESS_SPACE;	break;
+			case 1:	 value = 'z';				break;
+			case 2:	 value = KEY_PRESS_TAB;		break;
+			default: value = m_heldKey;			break;
+		}
+		return true;
+	}
+
+	virtual void playSound(int /* soundID */)
+	{
+	}
+
+	virtual void setGameStatText(string /* text */)
+	{
+	}
+
+	virtual void quitGame()
+	{
+		m_quit = true;
+	}
+
+	bool quitRequested() const
+	{
+		return m_quit;
+	}
+
+  private:
+	unsigned int m_state;
+	int			 m_heldKey;
+	bool		 m_quit;
+
+	  // The bot keeps its own generator so it never consumes the world's random numbers
+	unsigned int next()
+	{
+		m_state = m_state * 1664525u + 1013904223u;
+		return m_state >> 8;
+	}
+};
+
+static long parseOption(int argc, char* argv[], const char* name, long defaultValue)
+{
+	for (int k = 1; k + 1 < argc; k++)
+		if (strcmp(argv[k], name) == 0)
+			return strtol(argv[k + 1], nullptr, 10);
+	return defaultValue;
+}
+
+static const char* stringOption(int argc, char* argv[], const char* name)
+{
+	for (int k = 1; k + 1 < argc; k++)
+		if (strcmp(argv[k], name) == 0)
+			return argv[k + 1];
+	return nullptr;
+}
+
+static bool hasFlag(int argc, char* argv[], const char* name)
+{
+	for (int k = 1; k < argc; k++)
+		if (strcmp(argv[k], name) == 0)
+			return true;
+	return false;
+}
+
+struct GameResult
+{
+	unsigned int seed;
+	long		 ticks;
+	long		 levelsFinished;
+	long		 livesLost;
+	unsigned int score;
+	unsigned int level;
+	bool		 gameOver;
+	double		 seconds;
+	uint64_t	 checksum;	// FNV-1a over every tick's outcome
+	long		 levelsGenerated;
+	double		 generationSeconds;
+	unsigned long playerFloods;		// hardcore player-field floods run
+	unsigned long playerFloodsSaved;	// and avoided by sharing the field
+};
+
+  // Folds a tick's outcome into an FNV-1a checksum, before any level change it causes
+static void addOutcome(uint64_t& checksum, GameWorld* gw, int status)
+{
+	uint64_t outcome = (uint64_t(status) << 48) ^ (uint64_t(gw->getLevel()) << 40) ^
+		(uint64_t(gw->getLives()) << 32) ^ gw->getScore();
+	checksum = (checksum ^ outcome) * 1099511628211ULL;
+}
+
+  // Runs one tick and whatever level change it calls for; false once the game is over
+static bool stepGame(GameWorld* gw, int& status, uint64_t* checksum = nullptr)
+{
+	status = gw->move();
+	if (checksum != nullptr)
+		addOutcome(*checksum, gw, status);
+	if (status == GWSTATUS_PLAYER_DIED)
+	{
+		gw->cleanUp();
+		if (gw->isGameOver())
+			return false;
+		gw->init();
+	}
+	else if (status == GWSTATUS_FINISHED_LEVEL)
+	{
+		gw->advanceToNextLevel();
+		gw->cleanUp();
+		gw->init();
+	}
+	return true;
+}
+
+  // Starts the next level the way the game does, timing only the init() itself.
+  // With prefetch the level is prepared first and the wait for it, which the
+  // player would spend reading the prompt, is left out of the stall.
+static void startLevel(GameWorld* gw, bool prefetch, GameResult& result)
+{
+	if (prefetch)
+	{
+		gw->prepareNextLevel();
+		gw->finishPreparingLevel();
+	}
+	gw->init();
+	result.levelsGenerated++;
+	result.generationSeconds += gw->getGenerationSeconds();
+}
+
+  // Plays one game in a fresh world until it is over or a limit is reached,
+  // logging the keys the world reads into log if there is one
+static GameResult playGame(unsigned int seed, long maxTicks, long maxLevels, bool prefetch, int protesterThreads = 1, InputLog* log = nullptr)
+{
+	GameResult result = { seed, 0, 0, 0, 0, 0, false, 0, 14695981039346656037ULL, 0, 0, 0, 0 };
+	HeadlessHost host(seed);
+	InputLog unused;
+	InputRecorder recorder(host, log != nullptr ? *log : unused);
+	auto start = chrono::steady_clock::now();
+
+	GameWorld* gw = createStudentWorld("");
+	gw->setController(log != nullptr ? static_cast<GameHost*>(&recorder) : &host);
+	gw->setSeed(seed);
+	gw->setProtesterThreads(protesterThreads);
+	if (log != nullptr)
+		log->reset(seed);
+	startLevel(gw, prefetch, result);
+
+	while (result.ticks < maxTicks && (maxLevels <= 0 || result.levelsFinished < maxLevels) && !host.quitRequested())
+	{
+		if (log != nullptr)
+			recorder.startTick();
+		int status = gw->move();
+		result.ticks++;
+		addOutcome(result.checksum, gw, status);
+
+		if (status == GWSTATUS_PLAYER_DIED)
+		{
+			result.livesLost++;
+			gw->cleanUp();
+			if (gw->isGameOver())
+			{
+				result.gameOver = true;
+				break;
+			}
+			startLevel(gw, prefetch, result);
+		}
+		else if (status == GWSTATUS_FINISHED_LEVEL)
+		{
+			result.levelsFinished++;
+			gw->advanceToNextLevel();
+			gw->cleanUp();
+			startLevel(gw, prefetch, result);
+		}
+	}
+
+	result.score = gw->getScore();
+	result.level = gw->getLevel();
+	result.playerFloods = gw->getPlayerBFSRuns();
+	result.playerFloodsSaved = gw->getPlayerBFSRunsSaved();
+	delete gw;
+	result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+  // A restored world must play on exactly as the one it was saved from: same
+  // outcome every tick, and byte-identical snapshots at the end of the window.
+  // A snapshot leaves out the caches restore rebuilds, so a cache the live
+  // world lets go stale only shows once it changes play: check long games on
+  // many seeds.
+struct SnapshotCheck
+{
+	long ticks = 0, games = 0, saves = 0, forks = 0, mismatches = 0;
+	double saveSeconds = 0, restoreSeconds = 0;
+	size_t largest = 0;
+};
+
+static void checkSnapshots(unsigned int seed, long maxTicks, long interval, SnapshotCheck& check)
+{
+	HeadlessHost host(seed);
+	GameWorld* gw = createStudentWorld("");
+	gw->setController(&host);
+	gw->setSeed(seed);
+	gw->init();
+
+	HeadlessHost forkHost(seed);
+	GameWorld* fork = nullptr;
+	long forkStart = 0;
+	bool forkMatches = true;
+
+	vector<unsigned char> snapshot;
+	vector<unsigned char> forkSnapshot;
+	long ticks = 0;
+	bool running = true;
+
+	while (running && ticks < maxTicks && !host.quitRequested())
+	{
+		auto start = chrono::steady_clock::now();
+		gw->saveSnapshot(snapshot);
+		check.saveSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		check.saves++;
+		check.largest = max(check.largest, snapshot.size());
+
+		if (fork == nullptr && ticks % interval == 0)
+		{
+			forkHost = host;
+			fork = createStudentWorld("");
+			fork->setController(&forkHost);
+			start = chrono::steady_clock::now();
+			forkMatches = fork->restoreSnapshot(snapshot);
+			check.restoreSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			forkStart = ticks;
+			check.forks++;
+		}
+
+		int status = 0;
+		running = stepGame(gw, status);
+		ticks++;
+
+		if (fork != nullptr)
+		{
+			int forkStatus = 0;
+			bool forkRunning = forkMatches && stepGame(fork, forkStatus);
+			forkMatches = forkMatches && status == forkStatus && running == forkRunning &&
+				gw->getScore() == fork->getScore() && gw->getLives() == fork->getLives() && gw->getLevel() == fork->getLevel();
+
+			if (!forkMatches || !running || ticks - forkStart == interval)
+			{
+				if (forkMatches && running)
+				{
+					gw->saveSnapshot(snapshot);
+					fork->saveSnapshot(forkSnapshot);
+					forkMatches = snapshot == forkSnapshot;
+				}
+				if (!forkMatches)
+				{
+					check.mismatches++;
+					cout << "seed " << seed << ": restored world diverged between ticks " << forkStart << " and " << ticks << endl;
+				}
+				delete fork;
+				fork = nullptr;
+			}
+		}
+	}
+	delete fork;
+	delete gw;
+	check.ticks += ticks;
+	check.games++;
+}
+
+static int runSnapshotCheck(unsigned int seed, long seeds, long maxTicks, long interval)
+{
+	SnapshotCheck check;
+	for (long k = 0; k < seeds; k++)
+		checkSnapshots(seed + static_cast<unsigned int>(k), maxTicks, interval, check);
+
+	cout << "seeds:           " << seed;
+	if (seeds > 1)
+		cout << " to " << seed + static_cast<unsigned int>(seeds - 1);
+	cout << endl;
+	cout << "ticks:           " << check.ticks << " in " << check.games << (check.games == 1 ? " game" : " games") << endl;
+	cout << "snapshots:       " << check.saves << ", " << check.saveSeconds * 1e6 / max(1L, check.saves) << " us each, up to " << check.largest << " bytes" << endl;
+	cout << "restores:        " << check.forks << ", " << check.restoreSeconds * 1e6 / max(1L, check.forks) << " us each" << endl;
+	cout << "mismatches:      " << check.mismatches << endl;
+	return check.mismatches == 0 ? 0 : 1;
+}
+
+static int runRecord(const char* path, unsigned int seed, long maxTicks, long maxLevels, bool prefetch)
+{
+	InputLog log;
+	GameResult r = playGame(seed, maxTicks, maxLevels, prefetch, 1, &log);
+	if (!log.save(path))
+	{
+		cerr << "Cannot write " << path << endl;
+		return 1;
+	}
+	cout << "seed:            " << seed << endl;
+	cout << "ticks:           " << r.ticks << (r.gameOver ? " (game over)" : "") << endl;
+	cout << "keys logged:     " << log.getEvents().size() << " to " << path << endl;
+	cout << "final score:     " << r.score << " (level " << r.level << ")" << endl;
+	cout << "game checksum:   " << hex << r.checksum << dec << endl;
+	return 0;
+}
+
+  // Replays a recorded session with no drawing, sound or waiting between ticks
+static int runReplay(const char* path)
+{
+	InputLog log;
+	if (!log.load(path))
+	{
+		cerr << "Cannot read input log " << path << endl;
+		return 1;
+	}
+
+	InputPlayer player(log);
+	GameWorld* gw = createStudentWorld("");
+	gw->setController(&player);
+	gw->setSeed(log.getSeed());
+
+	auto start = chrono::steady_clock::now();
+	gw->init();
+	long ticks = 0;
+	uint64_t checksum = 14695981039346656037ULL;
+	bool running = true;
+	while (running && !player.finished() && !player.quitRequested())
+	{
+		player.startTick();
+		int status = 0;
+		running = stepGame(gw, status, &checksum);
+		ticks++;
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "seed:            " << log.getSeed() << endl;
+	cout << "ticks:           " << ticks << " of " << log.getTickCount() << " recorded" << (running ? "" : " (game over)") << endl;
+	cout << "keys:            " << log.getEvents().size() << endl;
+	cout << "final score:     " << gw->getScore() << " (level " << gw->getLevel() << ")" << endl;
+	cout << "game checksum:   " << hex << checksum << dec << endl;
+	cout << "elapsed:         " << seconds * 1e3 << " ms" << endl;
+	cout << "ticks/second:    " << (seconds > 0 ? ticks / seconds : 0) << endl;
+	delete gw;
+	return 0;
+}
+
+static int runRewindCheck(unsigned int seed, long maxTicks, long interval)
+{
+	HeadlessHost host(seed);
+	GameWorld* gw = createStudentWorld("");
+	gw->setController(&host);
+	gw->setSeed(seed);
+	gw->setRewindEnabled(true);
+	gw->init();
+
+	  // Every tick of the current level in full, to check rewinds against
+	vector<vector<unsigned char>> history(1);
+	gw->saveSnapshot(history.back());
+	vector<unsigned char> snapshot;
+	unsigned int pick = seed * 2654435761u + 7;
+
+	long ticks = 0, rewinds = 0, ticksRewound = 0, mismatches = 0;
+	double rewindSeconds = 0, worstRewind = 0;
+	RewindStats fullest = gw->getRewindStats();
+	bool running = true;
+
+	auto start = chrono::steady_clock::now();
+	while (running && ticks < maxTicks && !host.quitRequested())
+	{
+		int status = 0;
+		running = stepGame(gw, status);
+		ticks++;
+		if (!running)
+			break;
+		if (status != GWSTATUS_CONTINUE_GAME)
+			history.clear();	// a new level: rewind cannot reach back past it
+		history.emplace_back();
+		gw->saveSnapshot(history.back());
+
+		RewindStats stats = gw->getRewindStats();
+		if (stats.ticks > fullest.ticks)
+			fullest = stats;
+
+		if (ticks % interval == 0 && stats.ticks > 0)
+		{
+			pick = pick * 1664525u + 1013904223u;
+			int back = 1 + static_cast<int>((pick >> 8) % min<size_t>(stats.ticks, 2000));
+			int went = gw->rewind(back);
+			RewindStats after = gw->getRewindStats();
+			rewinds++;
+			ticksRewound += went;
+			rewindSeconds += after.lastRewindSeconds;
+			worstRewind = max(worstRewind, after.lastRewindSeconds);
+
+			history.resize(history.size() - went);
+			gw->saveSnapshot(snapshot);
+			if (went != back || snapshot != history.back())
+			{
+				mismatches++;
+				cout << "rewind of " << back << " ticks at tick " << ticks << " restored the wrong state" << endl;
+			}
+		}
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	delete gw;
+
+	cout << "seed:            " << seed << endl;
+	cout << "ticks:           " << ticks << (running ? "" : " (game over)") << " in " << seconds << " s" << endl;
+	cout << "history:         up to " << fullest.ticks << " ticks in " << fullest.bytes << " of " << fullest.budget << " bytes ("
+		 << fullest.bytes / max<size_t>(1, fullest.ticks + 1) << " bytes/tick)" << endl;
+	cout << "rewinds:         " << rewinds << ", " << ticksRewound / max(1L, rewinds) << " ticks back on average" << endl;
+	cout << "rewind latency:  " << rewindSeconds * 1e6 / max(1L, rewinds) << " us mean, " << worstRewind * 1e6 << " us worst" << endl;
+	cout << "mismatches:      " << mismatches << endl;
+	return mismatches == 0 ? 0 : 1;
+}
+
+  // Plays back-to-back games on this thread until the tick or level budget is spent
+static int runSequential(unsigned int seed, long maxTicks, long maxLevels, bool prefetch, int protesterThreads)
+{
+	long ticks = 0;
+	long levelsFinished = 0;
+	long livesLost = 0;
+	long gamesPlayed = 0;
+	unsigned int lastScore = 0;
+	unsigned int bestLevel = 0;
+	long levelsGenerated = 0;
+	double generationSeconds = 0;
+	unsigned long playerFloods = 0, playerFloodsSaved = 0;
+	uint64_t checksum = 14695981039346656037ULL;
+
+	auto start = chrono::steady_clock::now();
+
+	while (ticks < maxTicks && (maxLevels <= 0 || levelsFinished < maxLevels))
+	{
+		GameResult r = playGame(seed + gamesPlayed, maxTicks - ticks, maxLevels > 0 ? maxLevels - levelsFinished : 0, prefetch, protesterThreads);
+		gamesPlayed++;
+		ticks += r.ticks;
+		levelsFinished += r.levelsFinished;
+		livesLost += r.livesLost;
+		lastScore = r.score;
+		bestLevel = max(bestLevel, r.level);
+		levelsGenerated += r.levelsGenerated;
+		generationSeconds += r.generationSeconds;
+		playerFloods += r.playerFloods;
+		playerFloodsSaved += r.playerFloodsSaved;
+		checksum = (checksum ^ r.checksum) * 1099511628211ULL;
+		if (!r.gameOver)
+			break;
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "seed:            " << seed << endl;
+	cout << "ticks:           " << ticks << endl;
+	cout << "games played:    " << gamesPlayed << endl;
+	cout << "levels finished: " << levelsFinished << " (highest level " << bestLevel << ")" << endl;
+	cout << "lives lost:      " << livesLost << endl;
+	cout << "last score:      " << lastScore << endl;
+	cout << "checksum:        " << hex << checksum << dec << endl;
+	cout << "init stall:      " << levelsGenerated << " levels, " << generationSeconds * 1e6 / max(1L, levelsGenerated) << " us each"
+		 << (prefetch ? " (prepared in background)" : " (generated in init)") << endl;
+	cout << "player floods:   " << playerFloods << " run, " << playerFloodsSaved << " saved by sharing the field" << endl;
+	cout << "elapsed:         " << seconds << " s" << endl;
+	cout << "ticks/second:    " << (seconds > 0 ? ticks / seconds : 0) << endl;
+	return 0;
+}
+
+  // Plays one game per world, seeds seed .. seed+worlds-1, spread over a pool of threads
+static int runBatch(unsigned int seed, long worlds, int threads, long maxTicks, long maxLevels, bool perWorld, bool prefetch)
+{
+	vector<GameResult> results(worlds);
+	atomic<long> nextWorld(0);
+
+	auto start = chrono::steady_clock::now();
+
+	vector<thread> pool;
+	for (int t = 0; t < threads; t++)
+	{
+		pool.emplace_back([&]() {
+			for (long w = nextWorld++; w < worlds; w = nextWorld++)
+				results[w] = playGame(seed + static_cast<unsigned int>(w), maxTicks, maxLevels, prefetch);
+		});
+	}
+	for (auto& worker : pool)
+		worker.join();
+
+	double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	long totalTicks = 0;
+	long gamesOver = 0;
+	double sumScore = 0, sumLevel = 0, sumTicks = 0, sumRate = 0;
+	unsigned int minScore = results[0].score, maxScore = results[0].score, maxLevel = 0;
+	long minTicks = results[0].ticks, maxTicksSeen = results[0].ticks;
+	long levelsGenerated = 0;
+	double generationSeconds = 0;
+	uint64_t checksum = 14695981039346656037ULL;
+
+	for (const GameResult& r : results)
+	{
+		if (perWorld)
+			cout << "world seed " << r.seed << ": ticks " << r.ticks << ", score " << r.score
+				 << ", level " << r.level << (r.gameOver ? ", game over" : ", limit reached")
+				 << ", " << (r.seconds > 0 ? r.ticks / r.seconds : 0) << " ticks/s" << endl;
+		totalTicks += r.ticks;
+		gamesOver += r.gameOver ? 1 : 0;
+		sumScore += r.score;
+		sumLevel += r.level;
+		sumTicks += r.ticks;
+		sumRate += r.seconds > 0 ? r.ticks / r.seconds : 0;
+		minScore = min(minScore, r.score);
+		maxScore = max(maxScore, r.score);
+		maxLevel = max(maxLevel, r.level);
+		minTicks = min(minTicks, r.ticks);
+		maxTicksSeen = max(maxTicksSeen, r.ticks);
+		levelsGenerated += r.levelsGenerated;
+		generationSeconds += r.generationSeconds;
+		checksum = (checksum ^ r.checksum) * 1099511628211ULL;
+	}
+
+	cout << "worlds:            " << worlds << " on " << threads << " threads (seeds " << seed << ".." << seed + worlds - 1 << ")" << endl;
+	cout << "games over:        " << gamesOver << " (" << worlds - gamesOver << " stopped at a limit)" << endl;
+	cout << "score:             mean " << sumScore / worlds << ", min " << minScore << ", max " << maxScore << endl;
+	cout << "level reached:     mean " << sumLevel / worlds << ", max " << maxLevel << endl;
+	cout << "ticks to finish:   mean " << sumTicks / worlds << ", min " << minTicks << ", max " << maxTicksSeen << endl;
+	cout << "checksum:          " << hex << checksum << dec << endl;
+	cout << "init stall:        " << levelsGenerated << " levels, " << generationSeconds * 1e6 / max(1L, levelsGenerated) << " us each"
+		 << (prefetch ? " (prepared in background)" : " (generated in init)") << endl;
+	cout << "total ticks:       " << totalTicks << " in " << wallSeconds << " s" << endl;
+	cout << "ticks/second:      " << (wallSeconds > 0 ? totalTicks / wallSeconds : 0) << " aggregate, "
+		 << sumRate / worlds << " mean per world" << endl;
+	return 0;
+}
+
+  // Times removing dead entries from a list of `size` short-lived objects, about
+  // a third of which die each round, with the old erase-per-death loop and the
+  // single-pass strategies from Reaping.h
+static int runReapBenchmark(long size)
+{
+	struct Item { bool alive; };
+	const int ROUNDS = 2000;
+	const char* names[] = { "vector::erase", "reapStable", "reapUnordered" };
+
+	for (int strategy = 0; strategy < 3; strategy++)
+	{
+		vector<Item> storage(size);
+		vector<Item*> items;
+		vector<Item*> spare;
+		for (Item& item : storage)
+			item.alive = true, items.push_back(&item);
+		unsigned int state = 12345;
+
+		auto start = chrono::steady_clock::now();
+		for (int round = 0; round < ROUNDS; round++)
+		{
+			for (Item* item : items)
+			{
+				state = state * 1664525u + 1013904223u;
+				if ((state >> 8) % 3 == 0)
+					item->alive = false;
+			}
+
+			auto retire = [&](Item* item) {
+				if (item->alive)
+					return false;
+				spare.push_back(item);
+				return true;
+			};
+			if (strategy == 0)
+			{
+				for (auto it = items.begin(); it != items.end(); )
+				{
+					if (retire(*it))
+						it = items.erase(it);
+					else
+						++it;
+				}
+			}
+			else if (strategy == 1)
+				reapStable(items, retire);
+			else
+				reapUnordered(items, retire);
+
+			while (!spare.empty())
+			{
+				spare.back()->alive = true;
+				items.push_back(spare.back());
+				spare.pop_back();
+			}
+		}
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << names[strategy] << ": " << seconds * 1e9 / ROUNDS << " ns per round (" << size << " entries)" << endl;
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	long benchSize = parseOption(argc, argv, "--bench-reap", 0);
+	if (benchSize > 0)
+		return runReapBenchmark(benchSize);
+
+	long maxTicks = parseOption(argc, argv, "--ticks", 100000);
+	long maxLevels = parseOption(argc, argv, "--levels", 0);
+	unsigned int seed = static_cast<unsigned int>(parseOption(argc, argv, "--seed", static_cast<long>(time(nullptr))));
+	long worlds = parseOption(argc, argv, "--worlds", 0);
+	bool prefetch = hasFlag(argc, argv, "--prefetch");
+
+	const char* replayPath = stringOption(argc, argv, "--replay");
+	if (replayPath != nullptr)
+		return runReplay(replayPath);
+	const char* recordPath = stringOption(argc, argv, "--record");
+	if (recordPath != nullptr)
+		return runRecord(recordPath, seed, maxTicks, maxLevels, prefetch);
+
+	long rewindInterval = parseOption(argc, argv, "--check-rewind", 0);
+	if (rewindInterval > 0)
+		return runRewindCheck(seed, maxTicks, rewindInterval);
+
+	long checkInterval = parseOption(argc, argv, "--check-snapshots", 0);
+	if (checkInterval > 0)
+		return runSnapshotCheck(seed, max(1L, parseOption(argc, argv, "--seeds", 1)), maxTicks, checkInterval);
+
+	if (worlds <= 0)
+	{
+		int protesterThreads = static_cast<int>(parseOption(argc, argv, "--protester-threads", 1));
+		return runSequential(seed, maxTicks, maxLevels, prefetch, protesterThreads);
+	}
+
+	long hardware = static_cast<long>(thread::hardware_concurrency());
+	int threads = static_cast<int>(max(1L, parseOption(argc, argv, "--threads", hardware > 0 ? hardware : 1)));
+	bool perWorld = hasFlag(argc, argv, "--per-world");
+	return runBatch(seed, worlds, threads, maxTicks, maxLevels, perWorld, prefetch);
+}
@@ -0,0 +1,170 @@
+#ifndef INPUTLOG_H_
+#define INPUTLOG_H_
+
+#include "GameWorld.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+// ============================================================================
+// INPUT LOG
+// Every key a world read, tagged with the tick it was read on, plus the seed
+// and the session length: with the world's own random stream that is enough
+// to replay a session exactly. Ticks count move() calls from 1 across the
+// whole game, level transitions included.
+//
+// On disk everything is an unsigned LEB128 varint: magic, version, seed, tick
+// count, key count, then per key the ticks since the previous key and the
+// key code. A held arrow key costs three bytes per tick it is read on.
+// ============================================================================
+class InputLog
+{
+public:
+    struct Event { uint64_t tick; int key; };
+
+    InputLog() : m_seed(0), m_ticks(0) {}
+
+    void reset(uint64_t seed) {
+        m_seed = seed;
+        m_ticks = 0;
+        m_events.clear();
+    }
+
+    void startTick() { m_ticks++; }
+    void addKey(int key) { m_events.push_back({ m_ticks, key }); }
+
+    uint64_t getSeed() const { return m_seed; }
+    uint64_t getTickCount() const { return m_ticks; }
+    const std::vector<Event>& getEvents() const { return m_events; }
+
+    bool save(const std::string& path) const {
+        std::vector<unsigned char> bytes;
+        putVarint(bytes, MAGIC);
+        putVarint(bytes, VERSION);
+        putVarint(bytes, m_seed);
+        putVarint(bytes, m_ticks);
+        putVarint(bytes, m_events.size());
+        uint64_t previous = 0;
+        for (const Event& event : m_events) {
+            putVarint(bytes, event.tick - previous);
+            putVarint(bytes, static_cast<uint32_t>(event.key));
+            previous = event.tick;
+        }
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        return bool(file);
+    }
+
+    // Leaves the log empty and returns false if the file is missing or malformed
+    bool load(const std::string& path) {
+        reset(0);
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        size_t pos = 0;
+        uint64_t magic, version, seed, ticks, count;
+        if (!getVarint(bytes, pos, magic) || magic != MAGIC || !getVarint(bytes, pos, version) || version != VERSION ||
+            !getVarint(bytes, pos, seed) || !getVarint(bytes, pos, ticks) || !getVarint(bytes, pos, count))
+            return false;
+
+        m_events.reserve(static_cast<size_t>(std::min<uint64_t>(count, bytes.size())));
+        uint64_t tick = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t delta, key;
+            if (!getVarint(bytes, pos, delta) || !getVarint(bytes, pos, key)) {
+                reset(0);
+                return false;
+            }
+            tick += delta;
+            m_events.push_back({ tick, static_cast<int>(static_cast<uint32_t>(key)) });
+        }
+        m_seed = seed;
+        m_ticks = ticks;
+        return true;
+    }
+
+private:
+    static const uint64_t MAGIC = 0x4c494d54; // "TMIL"
+    static const uint64_t VERSION = 1;
+
+    uint64_t m_seed;
+    uint64_t m_ticks;
+    std::vector<Event> m_events;
+
+    static void putVarint(std::vector<unsigned char>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    static bool getVarint(const std::vector<unsigned char>& in, size_t& pos, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+            unsigned char byte = in[pos++];
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+};
+
+// Passes another host through unchanged, logging every key the world reads.
+// The driver calls startTick() before each move().
+class InputRecorder : public GameHost
+{
+public:
+    InputRecorder(GameHost& host, InputLog& log) : m_host(host), m_log(log) {}
+
+    void startTick() { m_log.startTick(); }
+
+    virtual bool getLastKey(int& value) {
+        if (!m_host.getLastKey(value)) return false;
+        m_log.addKey(value);
+        return true;
+    }
+    virtual void playSound(int soundID) { m_host.playSound(soundID); }
+    virtual void setGameStatText(std::string text) { m_host.setGameStatText(text); }
+    virtual void quitGame() { m_host.quitGame(); }
+
+private:
+    GameHost& m_host;
+    InputLog& m_log;
+};
+
+// Hands a world back the keys of a recorded session on the ticks it read
+// them, silently. The driver calls startTick() before each move().
+class InputPlayer : public GameHost
+{
+public:
+    explicit InputPlayer(const InputLog& log) : m_log(log), m_tick(0), m_next(0), m_quit(false) {}
+
+    void startTick() { m_tick++; }
+    bool finished() const { return m_tick >= m_log.getTickCount(); }
+    bool quitRequested() const { return m_quit; }
+
+    virtual bool getLastKey(int& value) {
+        const std::vector<InputLog::Event>& events = m_log.getEvents();
+        while (m_next < events.size() && events[m_next].tick < m_tick) m_next++; // unread keys of a diverged replay
+        if (m_next >= events.size() || events[m_next].tick != m_tick) return false;
+        value = events[m_next++].key;
+        return true;
+    }
+    virtual void playSound(int /* soundID */) {}
+    virtual void setGameStatText(std::string /* text */) {}
+    virtual void quitGame() { m_quit = true; }
+
+private:
+    const InputLog& m_log;
+    uint64_t m_tick;
+    size_t m_next;
+    bool m_quit;
+};
+
+#endif // INPUTLOG_H_
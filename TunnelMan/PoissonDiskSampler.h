@@ -0,0 +1,83 @@
+#ifndef POISSONDISKSAMPLER_H_
+#define POISSONDISKSAMPLER_H_
+
+#include "GameConstants.h"
+#include "Random.h"
+#include <bitset>
+#include <cstdint>
+
+static_assert(VIEW_WIDTH <= 64, "PoissonDiskSampler packs each row into a single 64-bit mask");
+
+// ============================================================================
+// POISSON-DISK SAMPLER
+// Places points with a minimum spacing by drawing uniformly from the cells
+// still free instead of retrying random ones. Bit x of row y is set while
+// (x, y) may still take a point; each placement clears the disk around it.
+// The free set only shrinks, so every call finishes in one pass over the rows.
+// ============================================================================
+class PoissonDiskSampler
+{
+public:
+    // Every cell starts free except those in the given exclusion box (inclusive)
+    void reset(int exclX1, int exclY1, int exclX2, int exclY2) {
+        for (int y = 0; y < VIEW_HEIGHT; y++) {
+            m_free[y] = ~uint64_t(0);
+            if (y >= exclY1 && y <= exclY2) m_free[y] &= ~spanMask(exclX1, exclX2);
+        }
+    }
+
+    // Picks a free cell in the box uniformly at random and clears everything
+    // within `radius` of it. Returns false if the box has no free cell left.
+    bool place(Random& random, int x1, int y1, int x2, int y2, int radius, int& outX, int& outY) {
+        uint64_t box = spanMask(x1, x2);
+        int total = 0;
+        for (int y = y1; y <= y2; y++) total += popcount(m_free[y] & box);
+        if (total == 0) return false;
+
+        int pick = random.nextInt(total);
+        for (int y = y1; y <= y2; y++) {
+            uint64_t row = m_free[y] & box;
+            int count = popcount(row);
+            if (pick >= count) {
+                pick -= count;
+                continue;
+            }
+            for (int x = x1; x <= x2; x++) {
+                if (((row >> x) & 1) && pick-- == 0) {
+                    outX = x;
+                    outY = y;
+                    block(x, y, radius);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Clears every cell within `radius` of (x, y), edge included
+    void block(int x, int y, int radius) {
+        for (int dy = -radius; dy <= radius; dy++) {
+            int row = y + dy;
+            if (row < 0 || row >= VIEW_HEIGHT) continue;
+            int dx = 0;
+            while ((dx + 1) * (dx + 1) + dy * dy <= radius * radius) dx++;
+            m_free[row] &= ~spanMask(x - dx, x + dx);
+        }
+    }
+
+private:
+    uint64_t m_free[VIEW_HEIGHT];
+
+    static int popcount(uint64_t v) { return static_cast<int>(std::bitset<64>(v).count()); }
+
+    // Bits x1..x2 inclusive, clipped to the row
+    static uint64_t spanMask(int x1, int x2) {
+        if (x1 < 0) x1 = 0;
+        if (x2 > VIEW_WIDTH - 1) x2 = VIEW_WIDTH - 1;
+        if (x1 > x2) return 0;
+        uint64_t upper = (x2 >= 63) ? ~uint64_t(0) : ((uint64_t(1) << (x2 + 1)) - 1);
+        return upper & ~((uint64_t(1) << x1) - 1);
+    }
+};
+
+#endif // POISSONDISKSAMPLER_H_
@@ -0,0 +1,28 @@
+#ifndef PROXIMITY_H_
+#define PROXIMITY_H_
+
+// ============================================================================
+// PROXIMITY
+// Distances between actor positions are compared squared, in integers, so no
+// proximity test needs a square root or a conversion to double.
+// ============================================================================
+
+// Radii in squares
+const int PICKUP_RADIUS = 3;  // player collects a pickup, gold bribes a protester
+const int HIT_RADIUS = 3;     // squirts and falling boulders annoy what they reach
+const int BOULDER_RADIUS = 3; // nothing may step this close to a boulder
+const int SHOUT_RADIUS = 4;   // protesters stop to shout at the player
+const int REVEAL_RADIUS = 4;  // hidden pickups show themselves to the player
+const int SPACING_RADIUS = 6; // minimum gap between objects placed at level start
+const int SONAR_RADIUS = 12;
+
+inline int squaredDistance(int x1, int y1, int x2, int y2) {
+    int dx = x1 - x2, dy = y1 - y2;
+    return dx * dx + dy * dy;
+}
+
+inline bool isWithinRadius(int x1, int y1, int x2, int y2, int radius) {
+    return squaredDistance(x1, y1, x2, y2) <= radius * radius;
+}
+
+#endif // PROXIMITY_H_
@@ -0,0 +1,44 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <cstdint>
+
+// ============================================================================
+// RANDOM
+// PCG32 (XSH-RR) generator. Each instance is an independent, seedable stream,
+// so two objects seeded alike produce identical sequences.
+// ============================================================================
+class Random
+{
+public:
+    explicit Random(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+        setSeed(seed, stream);
+    }
+
+    void setSeed(uint64_t seed, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+        m_state = 0;
+        m_inc = (stream << 1) | 1;
+        next();
+        m_state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = m_state;
+        m_state = old * 6364136223846793005ULL + m_inc;
+        uint32_t xorshifted = uint32_t(((old >> 18) ^ old) >> 27);
+        uint32_t rot = uint32_t(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    // Uniform in [0, bound); bound must be positive
+    int nextInt(int bound) {
+        return int((uint64_t(next()) * uint32_t(bound)) >> 32);
+    }
+
+private:
+    uint64_t m_state;
+    uint64_t m_inc;
+};
+
+#endif // RANDOM_H_
@@ -0,0 +1,43 @@
+#ifndef REAPING_H_
+#define REAPING_H_
+
+#include <vector>
+#include <cstddef>
+
+// ============================================================================
+// REAPING
+// Single-pass removal of dead entries from an actor list. retire(item) returns
+// true if the item is dead; it is then responsible for disposing of it.
+// ============================================================================
+
+// Keeps survivors in their original order: O(n) moves no matter how many die
+template <typename T, typename Retire>
+void reapStable(std::vector<T>& items, Retire retire)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (!retire(items[i])) {
+            if (kept != i) items[kept] = items[i];
+            kept++;
+        }
+    }
+    items.resize(kept);
+}
+
+// Fills each hole with the last element; cheapest when update order does not matter
+template <typename T, typename Retire>
+void reapUnordered(std::vector<T>& items, Retire retire)
+{
+    size_t i = 0;
+    while (i < items.size()) {
+        if (retire(items[i])) {
+            items[i] = items.back();
+            items.pop_back();
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+#endif // REAPING_H_
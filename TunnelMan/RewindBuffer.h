@@ -0,0 +1,192 @@
+#ifndef REWINDBUFFER_H_
+#define REWINDBUFFER_H_
+
+#include <vector>
+#include <deque>
+#include <cstddef>
+#include <cstring>
+
+// ============================================================================
+// REWIND BUFFER
+// Recent world snapshots, one per tick, in a fixed-size byte ring. Every
+// KEYFRAME_INTERVAL-th entry is stored whole; the rest are deltas against the
+// entry before. When the ring is full the oldest entries are overwritten,
+// together with any deltas left without the keyframe they build on.
+//
+// A delta is the new snapshot's length followed by (skip, count, bytes) runs:
+// skip bytes are unchanged from the previous snapshot, then count bytes are
+// given literally. Lengths are LEB128 varints.
+// ============================================================================
+class RewindBuffer
+{
+public:
+    static const int KEYFRAME_INTERVAL = 64;
+
+    explicit RewindBuffer(size_t budgetBytes = 0) : m_ring(budgetBytes), m_writePos(0), m_sinceKeyframe(0) {}
+
+    // Drops the history; a budget of 0 frees the ring
+    void setBudget(size_t budgetBytes) {
+        std::vector<unsigned char>(budgetBytes).swap(m_ring);
+        clear();
+    }
+
+    void clear() {
+        m_entries.clear();
+        m_writePos = 0;
+        m_sinceKeyframe = 0;
+        m_last.clear();
+    }
+
+    // Number of snapshots held; the newest is entry size() - 1
+    size_t size() const { return m_entries.size(); }
+    size_t getBudget() const { return m_ring.size(); }
+
+    size_t getBytesUsed() const {
+        size_t bytes = 0;
+        for (const Entry& entry : m_entries) bytes += entry.size;
+        return bytes;
+    }
+
+    void push(const std::vector<unsigned char>& snapshot) {
+        bool keyframe = m_entries.empty() || m_sinceKeyframe + 1 >= KEYFRAME_INTERVAL;
+        if (keyframe) {
+            store(snapshot.data(), snapshot.size(), true);
+        }
+        else {
+            m_scratch.clear();
+            encodeDelta(m_last, snapshot, m_scratch);
+            store(m_scratch.data(), m_scratch.size(), false);
+        }
+        m_last = snapshot;
+    }
+
+    // Rebuilds the snapshot `back` entries before the newest into out
+    bool get(size_t back, std::vector<unsigned char>& out) const {
+        if (back >= m_entries.size()) return false;
+        size_t target = m_entries.size() - 1 - back;
+        size_t first = target;
+        while (!m_entries[first].keyframe) first--; // the oldest entry is always a keyframe
+
+        const Entry& key = m_entries[first];
+        out.assign(m_ring.begin() + key.offset, m_ring.begin() + key.offset + key.size);
+        for (size_t i = first + 1; i <= target; i++) {
+            const Entry& delta = m_entries[i];
+            applyDelta(&m_ring[delta.offset], delta.size, out, m_applied);
+            out.swap(m_applied);
+        }
+        return true;
+    }
+
+    // Forgets the newest `count` entries, e.g. the ticks a rewind stepped back over
+    void dropNewest(size_t count) {
+        if (count == 0) return;
+        count = count < m_entries.size() ? count : m_entries.size();
+        m_entries.resize(m_entries.size() - count);
+        m_sinceKeyframe = 0;
+        for (size_t i = m_entries.size(); i-- > 0 && !m_entries[i].keyframe; ) m_sinceKeyframe++;
+        m_writePos = m_entries.empty() ? 0 : m_entries.back().offset + m_entries.back().size;
+        if (m_entries.empty() || !get(0, m_last)) m_last.clear();
+    }
+
+private:
+    struct Entry { size_t offset; size_t size; bool keyframe; };
+
+    std::vector<unsigned char> m_ring;
+    std::deque<Entry> m_entries;      // oldest first, in ring order
+    size_t m_writePos;
+    int m_sinceKeyframe;
+    std::vector<unsigned char> m_last;          // the newest snapshot, the base for the next delta
+    std::vector<unsigned char> m_scratch;
+    mutable std::vector<unsigned char> m_applied;
+
+    void store(const unsigned char* data, size_t size, bool keyframe) {
+        if (size > m_ring.size()) { // can never fit; start over from the next keyframe
+            clear();
+            return;
+        }
+        if (m_writePos + size > m_ring.size()) {
+            // The tail is smaller than this entry and holds only the oldest entries
+            while (!m_entries.empty() && m_entries.front().offset >= m_writePos) evictOldest();
+            m_writePos = 0;
+        }
+        while (!m_entries.empty() && m_entries.front().offset >= m_writePos && m_entries.front().offset < m_writePos + size)
+            evictOldest();
+        if (!keyframe && m_entries.empty()) { // its keyframe was just overwritten
+            m_sinceKeyframe = 0;
+            return;
+        }
+
+        std::memcpy(&m_ring[m_writePos], data, size);
+        m_entries.push_back({ m_writePos, size, keyframe });
+        m_writePos += size;
+        m_sinceKeyframe = keyframe ? 0 : m_sinceKeyframe + 1;
+    }
+
+    // Deltas cannot outlive their keyframe
+    void evictOldest() {
+        m_entries.pop_front();
+        while (!m_entries.empty() && !m_entries.front().keyframe) m_entries.pop_front();
+    }
+
+    static void putVarint(std::vector<unsigned char>& out, size_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    static size_t getVarint(const unsigned char*& p) {
+        size_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            unsigned char byte = *p++;
+            value |= size_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+    }
+
+    static void encodeDelta(const std::vector<unsigned char>& from, const std::vector<unsigned char>& to, std::vector<unsigned char>& out) {
+        const size_t MIN_SKIP = 4; // shorter matches cost more as a new run than as literals
+        size_t shared = from.size() < to.size() ? from.size() : to.size();
+        putVarint(out, to.size());
+
+        size_t pos = 0;
+        while (pos < to.size()) {
+            size_t skipEnd = pos;
+            while (skipEnd < shared && from[skipEnd] == to[skipEnd]) skipEnd++;
+            if (skipEnd == to.size()) break;
+
+            size_t copyEnd = skipEnd;
+            for (;;) {
+                while (copyEnd < to.size() && (copyEnd >= shared || from[copyEnd] != to[copyEnd])) copyEnd++;
+                size_t match = copyEnd;
+                while (match < shared && match - copyEnd < MIN_SKIP && from[match] == to[match]) match++;
+                if (match - copyEnd >= MIN_SKIP || match == to.size()) break;
+                copyEnd = match;
+            }
+            putVarint(out, skipEnd - pos);
+            putVarint(out, copyEnd - skipEnd);
+            out.insert(out.end(), to.begin() + skipEnd, to.begin() + copyEnd);
+            pos = copyEnd;
+        }
+    }
+
+    static void applyDelta(const unsigned char* delta, size_t size, const std::vector<unsigned char>& from, std::vector<unsigned char>& to) {
+        const unsigned char* p = delta;
+        const unsigned char* end = delta + size;
+        to.resize(getVarint(p));
+
+        size_t pos = 0;
+        while (p < end) {
+            size_t skip = getVarint(p);
+            size_t count = getVarint(p);
+            std::memcpy(to.data() + pos, from.data() + pos, skip);
+            std::memcpy(to.data() + pos + skip, p, count);
+            p += count;
+            pos += skip + count;
+        }
+        if (pos < to.size()) std::memcpy(to.data() + pos, from.data() + pos, to.size() - pos); // unchanged tail
+    }
+};
+
+#endif // REWINDBUFFER_H_
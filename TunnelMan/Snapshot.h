@@ -0,0 +1,69 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+
+// ============================================================================
+// SNAPSHOT
+// Flat binary buffers for saving world state. Values are copied byte for
+// byte in the host's layout, so a snapshot is only meant to be read back by
+// the same build on the same kind of machine.
+// ============================================================================
+class SnapshotWriter
+{
+public:
+    explicit SnapshotWriter(std::vector<unsigned char>& out) : m_out(out) {}
+
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain values only");
+        putBytes(&value, sizeof(T));
+    }
+
+    void putBytes(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        m_out.insert(m_out.end(), bytes, bytes + size);
+    }
+
+private:
+    std::vector<unsigned char>& m_out;
+};
+
+// Reading past the end yields zeroes and clears ok(); callers check it once at the end
+class SnapshotReader
+{
+public:
+    SnapshotReader(const std::vector<unsigned char>& in) : m_data(in.data()), m_size(in.size()), m_pos(0), m_ok(true) {}
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain values only");
+        T value;
+        getBytes(&value, sizeof(T));
+        return value;
+    }
+
+    void getBytes(void* data, size_t size) {
+        if (!m_ok || m_size - m_pos < size) {
+            m_ok = false;
+            std::memset(data, 0, size);
+            return;
+        }
+        std::memcpy(data, m_data + m_pos, size);
+        m_pos += size;
+    }
+
+    bool ok() const { return m_ok; }
+    bool atEnd() const { return m_pos == m_size; }
+
+private:
+    const unsigned char* m_data;
+    size_t m_size;
+    size_t m_pos;
+    bool m_ok;
+};
+
+#endif // SNAPSHOT_H_
@@ -0,0 +1,66 @@
+#ifndef SPATIALINDEX_H_
+#define SPATIALINDEX_H_
+
+#include "GameConstants.h"
+#include <vector>
+#include <algorithm>
+
+class Actor;
+
+// ============================================================================
+// SPATIAL INDEX
+// Uniform grid of 8x8 buckets over the board. Radius queries only visit the
+// buckets overlapping the query square; callers still do the exact distance test.
+// ============================================================================
+class SpatialIndex
+{
+public:
+    static const int CELL_SIZE = 8;
+    static const int CELLS_X = (VIEW_WIDTH + CELL_SIZE - 1) / CELL_SIZE;
+    static const int CELLS_Y = (VIEW_HEIGHT + CELL_SIZE - 1) / CELL_SIZE;
+
+    void clear() {
+        for (auto& bucket : m_buckets) bucket.clear();
+    }
+
+    void insert(Actor* actor, int x, int y) {
+        m_buckets[bucketOf(x, y)].push_back(actor);
+    }
+
+    void remove(Actor* actor, int x, int y) {
+        std::vector<Actor*>& bucket = m_buckets[bucketOf(x, y)];
+        auto it = std::find(bucket.begin(), bucket.end(), actor);
+        if (it != bucket.end()) {
+            *it = bucket.back();
+            bucket.pop_back();
+        }
+    }
+
+    void move(Actor* actor, int oldX, int oldY, int newX, int newY) {
+        if (bucketOf(oldX, oldY) == bucketOf(newX, newY)) return;
+        remove(actor, oldX, oldY);
+        insert(actor, newX, newY);
+    }
+
+    // Calls visit(actor) for every actor in a bucket overlapping the square of
+    // the given radius around (x, y). Stops and returns true as soon as visit does.
+    template <typename Visitor>
+    bool visitNear(int x, int y, int radius, Visitor visit) const {
+        int cx1 = clampX((x - radius) / CELL_SIZE), cx2 = clampX((x + radius) / CELL_SIZE);
+        int cy1 = clampY((y - radius) / CELL_SIZE), cy2 = clampY((y + radius) / CELL_SIZE);
+        for (int cx = cx1; cx <= cx2; cx++)
+            for (int cy = cy1; cy <= cy2; cy++)
+                for (Actor* actor : m_buckets[cy * CELLS_X + cx])
+                    if (visit(actor)) return true;
+        return false;
+    }
+
+private:
+    std::vector<Actor*> m_buckets[CELLS_X * CELLS_Y];
+
+    static int clampX(int c) { return std::min(std::max(c, 0), CELLS_X - 1); }
+    static int clampY(int c) { return std::min(std::max(c, 0), CELLS_Y - 1); }
+    static int bucketOf(int x, int y) { return clampY(y / CELL_SIZE) * CELLS_X + clampX(x / CELL_SIZE); }
+};
+
+#endif // SPATIALINDEX_H_
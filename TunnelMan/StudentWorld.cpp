@@ -1,12 +1,16 @@
 #include "StudentWorld.h"
 #include "GameConstants.h"
 #include "Actor.h"
+#include "Reaping.h"
+#include "Snapshot.h"
 #include <string>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <cstdlib>
 #include <queue>
+#include <climits>
+#include <chrono>
 
 using namespace std;
 
@@ -16,17 +20,22 @@ GameWorld* createStudentWorld(string assetDir)
 }
 
 StudentWorld::StudentWorld(std::string assetDir)
-    : GameWorld(assetDir), m_player(nullptr), m_barrelsLeft(0),
-    m_ticksSinceLastProtester(0), m_targetNumProtesters(0), m_protesterCount(0), m_gridDirty(true)
+    : GameWorld(assetDir), m_player(nullptr),
+    m_protesters(PROTESTER_COMPONENTS), m_boulders(BOULDER_COMPONENTS),
+    m_pickups(PICKUP_COMPONENTS), m_squirts(SQUIRT_COMPONENTS),
+    m_tick(0), m_protesterThreads(1), m_triggersStale(true), m_triggerX(0), m_triggerY(0),
+    m_protesterRowsVisited(INT_MAX), m_pickupPassDone(true), m_barrelsLeft(0),
+    m_ticksSinceLastProtester(0), m_targetNumProtesters(0), m_protesterCount(0), m_generationSeconds(0), m_rewindEnabled(false), m_lastRewindSeconds(0), m_playerEpoch(0), m_gridDirty(true),
+    m_accessVersion(0), m_playerFieldValid(false), m_playerFieldX(0), m_playerFieldY(0),
+    m_playerFieldVersion(0), m_playerFieldDepth(0), m_playerBFSRuns(0), m_playerBFSRunsSaved(0)
 {
-    for (int x = 0; x < VIEW_WIDTH; x++)
-        for (int y = 0; y < VIEW_HEIGHT; y++)
-            m_earth[x][y] = nullptr;
+    for (int y = 0; y < VIEW_HEIGHT; y++) m_walkable[y] = 0;
 
     for (int x = 0; x < VIEW_WIDTH; x++) {
         for (int y = 0; y < VIEW_HEIGHT; y++) {
             m_grid_exit[x][y] = 0;
             m_grid_player[x][y] = 0;
+            m_playerStamp[x][y] = 0;
         }
     }
 }
@@ -38,39 +47,66 @@ StudentWorld::~StudentWorld()
 
 int StudentWorld::init()
 {
+    auto start = chrono::steady_clock::now();
+
     m_barrelsLeft = 0;
     m_protesterCount = 0;
     m_ticksSinceLastProtester = 0;
     m_targetNumProtesters = min(15, 2 + (int)(getLevel() * 1.5));
-    m_gridDirty = true;
-
-    for (int x = 0; x < VIEW_WIDTH; x++) {
-        for (int y = 0; y < 60; y++) {
-            if (x >= 30 && x <= 33 && y >= 4) continue;
-            m_earth[x][y] = new Earth(x, y, this);
-        }
+    flagGridAsDirty();
+    m_playerFieldValid = false;
+    m_protesterWakeups.reset(m_tick);
+    m_pickupExpiries.reset(m_tick);
+    m_protesterRowsVisited = INT_MAX;
+    m_pickupPassDone = true;
+    m_triggersStale = true;
+
+    // Take the level prepared in the background if there is one for this level
+    LevelPlan plan = m_nextLevel.valid() ? m_nextLevel.get() : generateLevel(getLevel(), m_random);
+    if (plan.level != getLevel()) plan = generateLevel(getLevel(), m_random);
+    m_random = plan.random;
+
+    m_earth = plan.earth;
+    for (int y = 0; y < VIEW_HEIGHT; y++) m_walkable[y] = plan.walkable[y];
+
+    m_player = createActor<Tunnelman>(this);
+
+    for (auto& pos : plan.boulders) {
+        spawnActor<Boulder>(pos.first, pos.second, this);
+        flagGridAsDirty();
+    }
+    for (auto& pos : plan.barrels) {
+        spawnActor<Barrel>(pos.first, pos.second, this);
+        m_barrelsLeft++;
+    }
+    for (auto& pos : plan.gold) {
+        spawnActor<GoldNugget>(pos.first, pos.second, this, false, true, false);
     }
-
-    m_player = new Tunnelman(this);
-
-    int current_level = getLevel();
-    int B = min(current_level / 2 + 2, 9);
-    int G = max(5 - current_level / 2, 2);
-    int L = min(2 + current_level, 21);
-    distributeItems(B, G, L);
 
     m_ticksSinceLastProtester = max(25, 200 - (int)getLevel());
 
+    m_rewind.clear();
+    recordRewindFrame();
+
+    m_generationSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
     return GWSTATUS_CONTINUE_GAME;
 }
 
 int StudentWorld::move()
 {
+    m_tick++;
+    m_protesterRowsVisited = 0;
+    m_pickupPassDone = false;
+
     updateDisplayText();
 
     if (m_gridDirty) {
         runBFS(60, 60, m_grid_exit);
         m_gridDirty = false;
+        m_dirtyAreas.clear();
+    }
+    else if (!m_dirtyAreas.empty()) {
+        repairExitField();
     }
 
     if (m_player->isAlive()) {
@@ -81,79 +117,193 @@ int StudentWorld::move()
         return GWSTATUS_PLAYER_DIED;
     }
 
-    size_t numActors = m_actors.size();
-    for (size_t i = 0; i < numActors; i++) {
-        if (m_actors[i]->isAlive()) {
-            m_actors[i]->doSomething();
-
-            if (!m_player->isAlive()) {
-                decLives();
-                return GWSTATUS_PLAYER_DIED;
-            }
-            if (m_barrelsLeft == 0) {
-                playSound(SOUND_FINISHED_LEVEL);
-                return GWSTATUS_FINISHED_LEVEL;
-            }
-        }
-    }
+    int status = updateBoulders();
+    if (status == GWSTATUS_CONTINUE_GAME) status = updateProtesters();
+    if (status == GWSTATUS_CONTINUE_GAME) status = updateSquirts();
+    if (status == GWSTATUS_CONTINUE_GAME) status = updatePickups();
+    if (status != GWSTATUS_CONTINUE_GAME) return status;
 
-    for (auto it = m_actors.begin(); it != m_actors.end(); ) {
-        if (!(*it)->isAlive()) {
-            delete* it;
-            it = m_actors.erase(it);
-        }
-        else {
-            ++it;
-        }
-    }
+    reapDeadActors();
 
-    // Dynamically count protesters to ensure accuracy
-    int currentProtesters = 0;
-    for (const auto& a : m_actors) {
-        if (a->isProtester()) currentProtesters++;
-    }
+    int currentProtesters = (int)m_protesters.size();
 
     int T = max(25, 200 - (int)getLevel());
     if (currentProtesters < m_targetNumProtesters && m_ticksSinceLastProtester >= T) {
         int probHardcore = min(90, (int)getLevel() * 10 + 30);
-        if (rand() % 100 < probHardcore) {
-            addActor(new HardcoreProtester(this));
+        if (randInt(100) < probHardcore) {
+            spawnActor<HardcoreProtester>(this);
         }
         else {
-            addActor(new RegularProtester(this));
+            spawnActor<RegularProtester>(this);
         }
         m_ticksSinceLastProtester = 0;
     }
     m_ticksSinceLastProtester++;
 
     int G = getLevel() * 25 + 300;
-    if (rand() % G == 0) {
-        if (rand() % 5 == 0) {
-            addActor(new SonarKit(0, 60, this));
+    if (randInt(G) == 0) {
+        if (randInt(5) == 0) {
+            spawnActor<SonarKit>(0, 60, this);
         }
         else {
             for (int k = 0; k < 100; k++) {
-                int x = rand() % 61;
-                int y = rand() % 61;
+                int x = randInt(61);
+                int y = randInt(61);
                 if (!isEarthAt(x, y) && !isEarthBelow(x, y) && !isBoulderAt(x, y)) {
-                    addActor(new WaterPool(x, y, this));
+                    spawnActor<WaterPool>(x, y, this);
                     break;
                 }
             }
         }
     }
 
+    recordRewindFrame();
     return GWSTATUS_CONTINUE_GAME;
 }
 
 void StudentWorld::cleanUp()
 {
-    if (m_player) { delete m_player; m_player = nullptr; }
-    for (auto x : m_actors) delete x;
+    if (m_player) { destroyActor(m_player); m_player = nullptr; }
+    for (auto x : m_actors) destroyActor(x);
     m_actors.clear();
-    for (int x = 0; x < VIEW_WIDTH; x++)
-        for (int y = 0; y < VIEW_HEIGHT; y++)
-            if (m_earth[x][y]) { delete m_earth[x][y]; m_earth[x][y] = nullptr; }
+    m_protesters.clear();
+    m_boulders.clear();
+    m_pickups.clear();
+    m_squirts.clear();
+    m_pickupTriggers.clear();
+    m_baitPickups.clear();
+    m_protesterWakeups.reset(m_tick);
+    m_pickupExpiries.reset(m_tick);
+    m_actorPool.reset();
+    m_actorIndex.clear();
+    m_earth.clear();
+    m_dirtyAreas.clear();
+}
+
+// ============================================================================
+// UPDATE PASSES
+// Actors spawned during a pass wait for the next tick, as they did when the
+// whole actor list was walked at once.
+// ============================================================================
+
+int StudentWorld::tickStatus() {
+    if (!m_player->isAlive()) {
+        decLives();
+        return GWSTATUS_PLAYER_DIED;
+    }
+    if (m_barrelsLeft == 0) {
+        playSound(SOUND_FINISHED_LEVEL);
+        return GWSTATUS_FINISHED_LEVEL;
+    }
+    return GWSTATUS_CONTINUE_GAME;
+}
+
+int StudentWorld::updateBoulders() {
+    size_t count = m_boulders.size();
+    for (size_t i = 0; i < count; i++) {
+        if (m_boulders.flags[i] & BOULDER_ASLEEP) continue;
+        Boulder* boulder = m_boulders.owner[i];
+        if (!boulder->isAlive()) continue;
+        boulder->doSomething();
+        int status = tickStatus();
+        if (status != GWSTATUS_CONTINUE_GAME) return status;
+    }
+    return GWSTATUS_CONTINUE_GAME;
+}
+
+// Only the protesters whose rest ends this tick are touched, in table order.
+// Nothing a protester does changes what another one plans from (the player's
+// position, the map, the path fields), so all of them are planned first,
+// possibly in parallel, and the plans applied after in the same order as ever.
+int StudentWorld::updateProtesters() {
+    m_dueProtesters.clear();
+    m_protesterWakeups.advance(m_tick, m_dueProtesters);
+    sort(m_dueProtesters.begin(), m_dueProtesters.end(), [](Protester* a, Protester* b) {
+        return a->getComponentRow() < b->getComponentRow();
+    });
+
+    // Hardcore tracking reads the player field, so it is built before the planners start.
+    // The first hardcore protester floods it; each one after counts a flood saved.
+    for (Protester* protester : m_dueProtesters) {
+        if (protester->isAlive() && protester->isHardcore()) updatePlayerField(protester->getTrackingRange());
+    }
+
+    size_t count = m_dueProtesters.size();
+    m_protesterPlans.resize(count);
+    size_t threads = (m_protesterThreads > 1 && count >= PARALLEL_PLAN_MIN) ? m_protesterThreads : 1;
+    size_t chunk = (count + threads - 1) / threads;
+    for (size_t t = 1; t < threads; t++)
+        m_planWorkers.push_back(async(launch::async, &StudentWorld::planProtesters, this, min(count, t * chunk), min(count, (t + 1) * chunk)));
+    planProtesters(0, min(count, chunk));
+    for (auto& worker : m_planWorkers) worker.get();
+    m_planWorkers.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        Protester* protester = m_dueProtesters[i];
+        m_protesterRowsVisited = protester->getComponentRow() + 1;
+        if (!protester->isAlive()) continue;
+        protester->applyMove(m_protesterPlans[i]);
+        int status = tickStatus();
+        if (status != GWSTATUS_CONTINUE_GAME) return status;
+    }
+    m_protesterRowsVisited = INT_MAX;
+    return GWSTATUS_CONTINUE_GAME;
+}
+
+void StudentWorld::planProtesters(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+        if (m_dueProtesters[i]->isAlive()) m_protesterPlans[i] = m_dueProtesters[i]->planMove();
+}
+
+int StudentWorld::updateSquirts() {
+    size_t count = m_squirts.size();
+    for (size_t i = 0; i < count; i++) {
+        Squirt* squirt = m_squirts.owner[i];
+        if (!squirt->isAlive()) continue;
+        squirt->doSomething();
+        int status = tickStatus();
+        if (status != GWSTATUS_CONTINUE_GAME) return status;
+    }
+    return GWSTATUS_CONTINUE_GAME;
+}
+
+// Expiring pickups come off the wheel. Player pickups near the player fire
+// their reveal or collect trigger, and bait gets its turn to bribe.
+int StudentWorld::updatePickups() {
+    m_duePickups.clear();
+    m_pickupExpiries.advance(m_tick, m_duePickups);
+    for (ActivatableObject* pickup : m_duePickups) pickup->setDead();
+    m_pickupPassDone = true;
+
+    m_firedPickups.clear();
+    int px = m_player->getX(), py = m_player->getY();
+    // Revealing is idempotent and collecting kills, so with neither side changed nothing new can fire
+    if (m_triggersStale || px != m_triggerX || py != m_triggerY) {
+        m_pickupTriggers.visitNear(px, py, REVEAL_RADIUS, [&](Actor* actor) {
+            if (actor->isWithin(px, py, REVEAL_RADIUS))
+                m_firedPickups.push_back(static_cast<ActivatableObject*>(actor));
+            return false;
+        });
+        m_triggersStale = false;
+        m_triggerX = px;
+        m_triggerY = py;
+    }
+    m_firedPickups.insert(m_firedPickups.end(), m_baitPickups.begin(), m_baitPickups.end());
+    sort(m_firedPickups.begin(), m_firedPickups.end(), [](ActivatableObject* a, ActivatableObject* b) {
+        return a->getComponentRow() < b->getComponentRow();
+    });
+
+    for (ActivatableObject* pickup : m_firedPickups) {
+        if (!pickup->isAlive()) continue;
+        if (pickup->isPickupableByPlayer()) {
+            if (pickup->isWithin(px, py, PICKUP_RADIUS)) pickup->collect();
+            else pickup->setVisible(true);
+        }
+        pickup->doSomething();
+        int status = tickStatus();
+        if (status != GWSTATUS_CONTINUE_GAME) return status;
+    }
+    return GWSTATUS_CONTINUE_GAME;
 }
 
 void StudentWorld::updateDisplayText() {
@@ -171,73 +321,177 @@ void StudentWorld::updateDisplayText() {
 
 void StudentWorld::addActor(Actor* actor) {
     m_actors.push_back(actor);
+    m_actorIndex.insert(actor, actor->getX(), actor->getY());
+}
+
+// The protester next acts once `ticks` of its own turns have been skipped
+void StudentWorld::setProtesterRest(Protester* protester, int ticks) {
+    int row = protester->getComponentRow();
+    int wake = m_tick + ticks + (row < m_protesterRowsVisited ? 1 : 0);
+    m_protesterWakeups.cancel(protester, m_protesters.timer[row]);
+    m_protesters.timer[row] = wake;
+    m_protesterWakeups.schedule(protester, wake);
+}
+
+void StudentWorld::sleepUntilDugUnder(Boulder* boulder) {
+    m_boulders.flags[boulder->getComponentRow()] |= BOULDER_ASLEEP;
+}
+
+// Wakes the sleeping boulders resting on the 4x4 block just dug at (x, y)
+void StudentWorld::wakeBouldersOver(int x, int y) {
+    for (size_t i = 0; i < m_boulders.size(); i++) {
+        int below = m_boulders.y[i] - 1;
+        if (below >= y && below <= y + 3 && m_boulders.x[i] <= x + 3 && m_boulders.x[i] + 3 >= x)
+            m_boulders.flags[i] &= ~BOULDER_ASLEEP;
+    }
+}
+
+void StudentWorld::trackActor(Protester* protester) {
+    m_protesters.add(protester, -1, 0);
+    setProtesterRest(protester, protester->getRestingTicks());
+}
+
+void StudentWorld::trackActor(Boulder* boulder) {
+    m_boulders.add(boulder, 0, 0);
+    flagAreaAsDirty(boulder->getX(), boulder->getY(), 3);
+}
+
+void StudentWorld::trackActor(ActivatableObject* pickup) {
+    unsigned char flags = 0;
+    if (pickup->isTemporary()) flags |= PICKUP_TEMPORARY;
+    if (pickup->isPickupableByPlayer()) flags |= PICKUP_BY_PLAYER;
+    if (pickup->isPickupableByEnemy()) flags |= PICKUP_BY_ENEMY;
+    if (flags & PICKUP_BY_PLAYER) {
+        m_pickupTriggers.insert(pickup, pickup->getX(), pickup->getY());
+        m_triggersStale = true;
+    }
+    if (flags & PICKUP_BY_ENEMY) m_baitPickups.push_back(pickup);
+    if (!pickup->isTemporary()) {
+        m_pickups.add(pickup, -1, flags);
+        return;
+    }
+    // Gone after `lifetime` pickup passes, counting this tick's if it has not run yet
+    int expiry = m_tick + pickup->getLifetime() - (m_pickupPassDone ? 0 : 1);
+    m_pickups.add(pickup, expiry, flags);
+    m_pickupExpiries.schedule(pickup, expiry);
+}
+
+void StudentWorld::trackActor(Squirt* squirt) {
+    m_squirts.add(squirt, 0, 0);
+}
+
+// One compaction pass instead of an erase per dead actor; update order is kept
+void StudentWorld::reapDeadActors() {
+    auto isDead = [](Actor* actor) { return !actor->isAlive(); };
+    m_protesters.reap([this](Protester* protester) {
+        if (protester->isAlive()) return false;
+        m_protesterWakeups.cancel(protester, m_protesters.timer[protester->getComponentRow()]);
+        return true;
+    });
+    m_boulders.reap(isDead);
+    m_pickups.reap([this](ActivatableObject* pickup) {
+        if (pickup->isAlive()) return false;
+        int row = pickup->getComponentRow();
+        m_pickupExpiries.cancel(pickup, m_pickups.timer[row]);
+        if (m_pickups.flags[row] & PICKUP_BY_PLAYER) m_pickupTriggers.remove(pickup, pickup->getX(), pickup->getY());
+        return true;
+    });
+    reapStable(m_baitPickups, isDead);
+    m_squirts.reap(isDead);
+
+    reapStable(m_actors, [this](Actor* actor) {
+        if (actor->isAlive()) return false;
+        m_actorIndex.remove(actor, actor->getX(), actor->getY());
+        if (actor->isBoulder()) flagAreaAsDirty(actor->getX(), actor->getY(), 3); // its footprint only opens up once it is gone
+        destroyActor(actor);
+        return true;
+    });
+}
+
+void StudentWorld::destroyActor(Actor* actor) {
+    actor->~Actor();
+    m_actorPool.deallocate(actor);
+}
+
+void StudentWorld::actorMoved(Actor* actor, int oldX, int oldY) {
+    if (actor == m_player) return; // the player is not part of m_actors
+    m_actorIndex.move(actor, oldX, oldY, actor->getX(), actor->getY());
+
+    int row = actor->getComponentRow();
+    switch (actor->getComponentKind()) {
+    case PROTESTER_COMPONENTS: m_protesters.x[row] = actor->getX(); m_protesters.y[row] = actor->getY(); break;
+    case BOULDER_COMPONENTS:   m_boulders.x[row] = actor->getX();   m_boulders.y[row] = actor->getY();   break;
+    case PICKUP_COMPONENTS:    m_pickups.x[row] = actor->getX();    m_pickups.y[row] = actor->getY();    break;
+    case SQUIRT_COMPONENTS:    m_squirts.x[row] = actor->getX();    m_squirts.y[row] = actor->getY();    break;
+    default: break;
+    }
 }
 
 bool StudentWorld::removeEarth(int x, int y) {
-    bool dug = false;
-    for (int i = x; i < x + 4; i++) {
-        for (int j = y; j < y + 4; j++) {
-            if (i >= 0 && i < VIEW_WIDTH && j >= 0 && j < VIEW_HEIGHT) {
-                if (m_earth[i][j]) {
-                    delete m_earth[i][j];
-                    m_earth[i][j] = nullptr;
-                    dug = true;
-                }
-            }
-        }
+    bool dug = m_earth.clearBlock(x, y, 4, 4);
+    if (dug) {
+        flagAreaAsDirty(x, y, 3);
+        wakeBouldersOver(x, y);
     }
-    if (dug) flagGridAsDirty();
     return dug;
 }
 
 bool StudentWorld::isEarthBelow(int x, int y) const {
-    for (int i = x; i < x + 4; i++) {
-        if (y - 1 >= 0 && m_earth[i][y - 1]) return true;
-    }
-    return false;
+    return m_earth.anyInBlock(x, y - 1, 4, 1);
 }
 
 bool StudentWorld::isEarthAt(int x, int y) const {
-    for (int i = x; i < x + 4; i++) {
-        for (int j = y; j < y + 4; j++) {
-            if (i >= 0 && i < VIEW_WIDTH && j >= 0 && j < VIEW_HEIGHT)
-                if (m_earth[i][j]) return true;
-        }
-    }
-    return false;
+    return m_earth.anyInBlock(x, y, 4, 4);
 }
 
 bool StudentWorld::isBoulderAt(int x, int y, int radius) {
-    for (auto* actor : m_actors) {
-        if (actor->isBoulder() && actor->getDistanceTo(x, y) <= radius) return true;
+    for (size_t i = 0; i < m_boulders.size(); i++) {
+        if (isWithinRadius(m_boulders.x[i], m_boulders.y[i], x, y, radius)) return true;
     }
     return false;
 }
 
 bool StudentWorld::isLocationAccessible(int x, int y) {
     if (x < 0 || x > 60 || y < 0 || y > 60) return false;
+    return (m_walkable[y] >> x) & 1;
+}
+
+bool StudentWorld::computeAccessible(int x, int y) {
     if (isEarthAt(x, y)) return false;
     if (isBoulderAt(x, y)) return false;
     return true;
 }
 
+void StudentWorld::refreshWalkable(int x1, int y1, int x2, int y2) {
+    for (int y = y1; y <= y2; y++) {
+        for (int x = x1; x <= x2; x++) {
+            uint64_t bit = uint64_t(1) << x;
+            if (computeAccessible(x, y)) m_walkable[y] |= bit;
+            else m_walkable[y] &= ~bit;
+        }
+    }
+}
+
 void StudentWorld::decreaseBarrelCount() {
     m_barrelsLeft--;
 }
 
 void StudentWorld::scanForItems(int x, int y, int radius) {
-    for (auto* actor : m_actors) {
-        if (!actor->isVisible() && actor->getDistanceTo(x, y) <= radius) {
+    m_actorIndex.visitNear(x, y, radius, [&](Actor* actor) {
+        if (!actor->isVisible() && actor->isWithin(x, y, radius)) {
             actor->setVisible(true);
         }
-    }
+        return false;
+    });
 }
 
 bool StudentWorld::annoyProtesters(int x, int y, int radius, int points) {
     bool hit = false;
-    for (auto* a : m_actors) {
-        if (a->canBeAnnoyed() && a->getDistanceTo(x, y) <= radius) {
-            static_cast<Agent*>(a)->decHP(points);
+    for (size_t i = 0; i < m_protesters.size(); i++) {
+        if (!isWithinRadius(m_protesters.x[i], m_protesters.y[i], x, y, radius)) continue;
+        Protester* p = m_protesters.owner[i];
+        if (p->canBeAnnoyed()) {
+            p->decHP(points);
             hit = true;
         }
     }
@@ -245,51 +499,286 @@ bool StudentWorld::annoyProtesters(int x, int y, int radius, int points) {
 }
 
 void StudentWorld::annoyAllNearbyActors(int x, int y, int radius, int points) {
-    if (m_player->getDistanceTo(x, y) <= radius) {
+    if (m_player->isWithin(x, y, radius)) {
         m_player->decHP(points);
     }
     annoyProtesters(x, y, radius, points);
 }
 
 bool StudentWorld::bribeEnemy(int x, int y) {
-    for (auto* a : m_actors) {
-        if (a->canBeAnnoyed() && a->getDistanceTo(x, y) <= 3.0) {
-            return a->beBribed();
-        }
+    for (size_t i = 0; i < m_protesters.size(); i++) {
+        if (!isWithinRadius(m_protesters.x[i], m_protesters.y[i], x, y, PICKUP_RADIUS)) continue;
+        Protester* p = m_protesters.owner[i];
+        if (p->canBeAnnoyed()) return p->beBribed();
     }
     return false;
 }
 
-void StudentWorld::distributeItems(int numBoulders, int numGold, int numBarrels)
+// ============================================================================
+// LEVEL GENERATION
+// Touches nothing but the plan and its random stream, so a level can be built
+// on a worker thread while the previous one's prompt is still up.
+// ============================================================================
+
+void StudentWorld::prepareNextLevel() {
+    if (m_nextLevel.valid()) return;
+    m_nextLevel = async(launch::async, &StudentWorld::generateLevel, getLevel(), m_random);
+}
+
+void StudentWorld::finishPreparingLevel() {
+    if (m_nextLevel.valid()) m_nextLevel.wait();
+}
+
+StudentWorld::LevelPlan StudentWorld::generateLevel(unsigned int level, Random random) {
+    LevelPlan plan;
+    plan.level = level;
+
+    plan.earth.fillStartingLayout();
+
+    int current_level = level;
+    int B = min(current_level / 2 + 2, 9);
+    int G = max(5 - current_level / 2, 2);
+    int L = min(2 + current_level, 21);
+    distributeItems(plan, random, B, G, L);
+
+    for (auto& pos : plan.boulders) plan.earth.clearBlock(pos.first, pos.second, 4, 4);
+    buildWalkable(plan);
+
+    plan.random = random;
+    return plan;
+}
+
+// Each item is drawn uniformly from the cells farther than SPACING_RADIUS from
+// every item placed before it, which is what retrying random cells converged
+// to, but in bounded time. Items that no longer fit anywhere are left out.
+void StudentWorld::distributeItems(LevelPlan& plan, Random& random, int numBoulders, int numGold, int numBarrels)
 {
-    for (int i = 0; i < numBoulders; i++) {
-        int x, y;
-        do { x = rand() % 61; y = rand() % 37 + 20; } while (!isPositionValid(x, y));
-        addActor(new Boulder(x, y, this));
-        flagGridAsDirty();
+    PoissonDiskSampler sampler;
+    sampler.reset(27, 5, 33, VIEW_HEIGHT - 1); // the shaft: x > 26 && x < 34 && y > 4
+    int x, y;
+
+    for (int i = 0; i < numBoulders && sampler.place(random, 0, 20, 60, 56, SPACING_RADIUS, x, y); i++)
+        plan.boulders.push_back({ x, y });
+    for (int i = 0; i < numBarrels && sampler.place(random, 0, 0, 60, 56, SPACING_RADIUS, x, y); i++)
+        plan.barrels.push_back({ x, y });
+    for (int i = 0; i < numGold && sampler.place(random, 0, 0, 60, 56, SPACING_RADIUS, x, y); i++)
+        plan.gold.push_back({ x, y });
+}
+
+// Same rule as computeAccessible, applied to the plan instead of the live world
+void StudentWorld::buildWalkable(LevelPlan& plan) {
+    for (int y = 0; y < VIEW_HEIGHT; y++) {
+        plan.walkable[y] = 0;
+        if (y > 60) continue;
+        for (int x = 0; x <= 60; x++) {
+            if (plan.earth.anyInBlock(x, y, 4, 4)) continue;
+            bool nearBoulder = false;
+            for (auto& b : plan.boulders)
+                if (isWithinRadius(b.first, b.second, x, y, BOULDER_RADIUS)) nearBoulder = true;
+            if (!nearBoulder) plan.walkable[y] |= uint64_t(1) << x;
+        }
     }
-    for (int i = 0; i < numBarrels; i++) {
-        int x, y;
-        do { x = rand() % 61; y = rand() % 57; } while (!isPositionValid(x, y));
-        addActor(new Barrel(x, y, this));
-        m_barrelsLeft++;
+}
+
+// ============================================================================
+// SNAPSHOTS
+// Everything move() reads, in a flat buffer. Caches that can be rebuilt from
+// it (exit field, player field, walkable map, indexes, wheels) are left out
+// and rebuilt on restore, so a restored world plays on exactly as the saved one.
+// ============================================================================
+
+static const uint32_t SNAPSHOT_MAGIC = 0x534e4d54; // "TMNS"
+static const uint32_t SNAPSHOT_VERSION = 1;
+
+bool StudentWorld::saveSnapshot(vector<unsigned char>& out) const {
+    out.clear();
+    if (m_player == nullptr) return false;
+
+    SnapshotWriter writer(out);
+    writer.put(SNAPSHOT_MAGIC);
+    writer.put(SNAPSHOT_VERSION);
+    writer.put(getLives());
+    writer.put(getScore());
+    writer.put(getLevel());
+    writer.put(m_random);
+    writer.put(m_tick);
+    writer.put(m_barrelsLeft);
+    writer.put(m_ticksSinceLastProtester);
+    writer.put(m_targetNumProtesters);
+    writer.put(m_earth);
+
+    saveActor(writer, m_player);
+    uint32_t count = 0;
+    for (Actor* actor : m_actors)
+        if (actor->isAlive()) count++;
+    writer.put(count);
+    for (Actor* actor : m_actors)
+        if (actor->isAlive()) saveActor(writer, actor);
+    return true;
+}
+
+// Tag, pose, the class's own state, then whatever its table row holds that the class does not
+void StudentWorld::saveActor(SnapshotWriter& out, const Actor* actor) const {
+    out.put(actor->getID());
+    out.put(actor->getX());
+    out.put(actor->getY());
+    out.put(actor->getDirection());
+    out.put(actor->isVisible());
+    actor->saveState(out);
+
+    int row = actor->getComponentRow();
+    switch (actor->getComponentKind()) {
+    case PROTESTER_COMPONENTS: out.put(m_protesters.timer[row]); break;
+    case BOULDER_COMPONENTS:   out.put(m_boulders.flags[row]);   break;
+    case PICKUP_COMPONENTS:    out.put(m_pickups.timer[row]);    break;
+    default: break;
     }
-    for (int i = 0; i < numGold; i++) {
-        int x, y;
-        do { x = rand() % 61; y = rand() % 57; } while (!isPositionValid(x, y));
-        addActor(new GoldNugget(x, y, this, false, true, false));
+}
+
+template <typename T>
+void StudentWorld::restoreActor(T* actor, GraphObject::Direction dir, bool visible, SnapshotReader& in) {
+    actor->setDirection(dir);
+    actor->setVisible(visible);
+    actor->loadState(in);
+    addActor(actor);
+    trackActor(actor);
+
+    // trackActor scheduled from the restored state; the saved row wins, and the wheels are rebuilt from it
+    int row = actor->getComponentRow();
+    switch (actor->getComponentKind()) {
+    case PROTESTER_COMPONENTS: m_protesters.timer[row] = in.get<int>();         break;
+    case BOULDER_COMPONENTS:   m_boulders.flags[row] = in.get<unsigned char>(); break;
+    case PICKUP_COMPONENTS:    m_pickups.timer[row] = in.get<int>();            break;
+    default: break;
     }
 }
 
-bool StudentWorld::isPositionValid(int x, int y)
-{
-    if (x > 26 && x < 34 && y > 4) return false;
-    for (auto* actor : m_actors) {
-        if (actor->getDistanceTo(x, y) <= 6.0) return false;
+// The rewind history belongs to the timeline being replaced, so it starts over here
+bool StudentWorld::restoreSnapshot(const vector<unsigned char>& in) {
+    if (!loadSnapshot(in)) return false;
+    m_rewind.clear();
+    recordRewindFrame();
+    return true;
+}
+
+bool StudentWorld::loadSnapshot(const vector<unsigned char>& in) {
+    SnapshotReader reader(in);
+    if (reader.get<uint32_t>() != SNAPSHOT_MAGIC || reader.get<uint32_t>() != SNAPSHOT_VERSION) return false;
+
+    cleanUp();
+    if (m_nextLevel.valid()) m_nextLevel.get(); // built from a stream the snapshot replaces
+
+    unsigned int lives = reader.get<unsigned int>();
+    unsigned int score = reader.get<unsigned int>();
+    unsigned int level = reader.get<unsigned int>();
+    setProgress(lives, score, level);
+    Random random = reader.get<Random>();
+    m_tick = reader.get<int>();
+    m_barrelsLeft = reader.get<int>();
+    m_ticksSinceLastProtester = reader.get<int>();
+    m_targetNumProtesters = reader.get<int>();
+    Terrain earth = reader.get<Terrain>(); // put in place after the boulders, whose constructors dig
+    m_protesterWakeups.reset(m_tick);
+    m_pickupExpiries.reset(m_tick);
+    m_protesterRowsVisited = INT_MAX;
+    m_pickupPassDone = true;
+
+    reader.get<unsigned int>(); // TID_PLAYER
+    int px = reader.get<int>(), py = reader.get<int>();
+    m_player = createActor<Tunnelman>(this);
+    m_player->GraphObject::moveTo(px, py);
+    m_player->setDirection(reader.get<GraphObject::Direction>());
+    m_player->setVisible(reader.get<bool>());
+    m_player->loadState(reader);
+
+    uint32_t count = reader.get<uint32_t>();
+    bool known = true;
+    for (uint32_t i = 0; i < count && known && reader.ok(); i++) {
+        unsigned int id = reader.get<unsigned int>();
+        int x = reader.get<int>(), y = reader.get<int>();
+        GraphObject::Direction dir = reader.get<GraphObject::Direction>();
+        bool visible = reader.get<bool>();
+        switch (id) {
+        case TID_PROTESTER:
+        case TID_HARD_CORE_PROTESTER: {
+            Protester* protester = id == TID_PROTESTER ? static_cast<Protester*>(createActor<RegularProtester>(this))
+                                                       : createActor<HardcoreProtester>(this);
+            protester->GraphObject::moveTo(x, y); // not yet indexed, so bypass Actor::moveTo
+            restoreActor(protester, dir, visible, reader);
+            break;
+        }
+        case TID_BOULDER:     restoreActor(createActor<Boulder>(x, y, this), dir, visible, reader);                       break;
+        case TID_BARREL:      restoreActor(createActor<Barrel>(x, y, this), dir, visible, reader);                        break;
+        case TID_GOLD:        restoreActor(createActor<GoldNugget>(x, y, this, false, true, false), dir, visible, reader); break;
+        case TID_SONAR:       restoreActor(createActor<SonarKit>(x, y, this), dir, visible, reader);                      break;
+        case TID_WATER_POOL:  restoreActor(createActor<WaterPool>(x, y, this), dir, visible, reader);                     break;
+        case TID_WATER_SPURT: restoreActor(createActor<Squirt>(x, y, this, dir), dir, visible, reader);                   break;
+        default:              known = false; break;
+        }
+    }
+
+    if (!known || !reader.ok() || !reader.atEnd()) {
+        cleanUp();
+        return false;
     }
+
+    // Rebuild the wheels from the restored rows
+    m_protesterWakeups.reset(m_tick);
+    m_pickupExpiries.reset(m_tick);
+    for (size_t i = 0; i < m_protesters.size(); i++)
+        m_protesterWakeups.schedule(m_protesters.owner[i], m_protesters.timer[i]);
+    for (size_t i = 0; i < m_pickups.size(); i++)
+        if (m_pickups.flags[i] & PICKUP_TEMPORARY) m_pickupExpiries.schedule(m_pickups.owner[i], m_pickups.timer[i]);
+
+    m_earth = earth;
+    for (int y = 0; y < VIEW_HEIGHT; y++) m_walkable[y] = 0;
+    refreshWalkable(0, 0, VIEW_WIDTH - 4, VIEW_HEIGHT - 4);
+    m_dirtyAreas.clear();
+    flagGridAsDirty();
+    m_playerFieldValid = false;
+    m_triggersStale = true;
+
+    m_random = random; // last: protester constructors draw from the stream
     return true;
 }
 
+// ============================================================================
+// REWIND
+// The end state of every tick goes into the ring; stepping back restores one
+// of them and forgets the ticks after it.
+// ============================================================================
+
+void StudentWorld::setRewindEnabled(bool enabled) {
+    if (enabled == m_rewindEnabled) return;
+    m_rewindEnabled = enabled;
+    m_rewind.setBudget(enabled ? REWIND_BUDGET : 0);
+    recordRewindFrame();
+}
+
+void StudentWorld::recordRewindFrame() {
+    if (!m_rewindEnabled || !saveSnapshot(m_rewindFrame)) return;
+    m_rewind.push(m_rewindFrame);
+}
+
+int StudentWorld::rewind(int ticks) {
+    if (!m_rewindEnabled || m_player == nullptr || ticks <= 0 || m_rewind.size() < 2) return 0;
+    size_t back = min(static_cast<size_t>(ticks), m_rewind.size() - 1);
+
+    auto start = chrono::steady_clock::now();
+    if (!m_rewind.get(back, m_rewindFrame) || !loadSnapshot(m_rewindFrame)) return 0;
+    m_rewind.dropNewest(back);
+    m_lastRewindSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    updateDisplayText();
+    return static_cast<int>(back);
+}
+
+RewindStats StudentWorld::getRewindStats() const {
+    RewindStats stats = { m_rewind.size() > 0 ? m_rewind.size() - 1 : 0, m_rewind.getBytesUsed(),
+                          m_rewind.getBudget(), m_lastRewindSeconds };
+    return stats;
+}
+
 void StudentWorld::runBFS(int targetX, int targetY, int outputGrid[VIEW_WIDTH][VIEW_HEIGHT]) {
     for (int x = 0; x < VIEW_WIDTH; x++)
         for (int y = 0; y < VIEW_HEIGHT; y++)
@@ -331,16 +820,168 @@ GraphObject::Direction StudentWorld::getDirectionToExit(int x, int y) {
     return GraphObject::none;
 }
 
+// Flood from the player that stops expanding at maxDepth. Rather than resetting
+// all 4,096 cells, each run bumps m_playerEpoch so stale entries read as -1.
+void StudentWorld::runBoundedPlayerBFS(int targetX, int targetY, int maxDepth) {
+    if (++m_playerEpoch == 0) {
+        for (int x = 0; x < VIEW_WIDTH; x++)
+            for (int y = 0; y < VIEW_HEIGHT; y++)
+                m_playerStamp[x][y] = 0;
+        m_playerEpoch = 1;
+    }
+
+    queue<pair<int, int>> q;
+    q.push({ targetX, targetY });
+    m_grid_player[targetX][targetY] = 0;
+    m_playerStamp[targetX][targetY] = m_playerEpoch;
+
+    int dirs[4][2] = { {0,1}, {0,-1}, {1,0}, {-1,0} };
+
+    while (!q.empty()) {
+        auto curr = q.front(); q.pop();
+        int cx = curr.first;
+        int cy = curr.second;
+        int dist = m_grid_player[cx][cy];
+        if (dist >= maxDepth) continue;
+
+        for (auto& d : dirs) {
+            int nx = cx + d[0];
+            int ny = cy + d[1];
+
+            if (isLocationAccessible(nx, ny) && m_playerStamp[nx][ny] != m_playerEpoch) {
+                m_grid_player[nx][ny] = dist + 1;
+                m_playerStamp[nx][ny] = m_playerEpoch;
+                q.push({ nx, ny });
+            }
+        }
+    }
+}
+
+void StudentWorld::updatePlayerField(int maxDepth) {
+    int px = m_player->getX();
+    int py = m_player->getY();
+    if (m_playerFieldValid && m_playerFieldX == px && m_playerFieldY == py &&
+        m_playerFieldVersion == m_accessVersion && m_playerFieldDepth >= maxDepth) {
+        m_playerBFSRunsSaved++;
+        return;
+    }
+
+    runBoundedPlayerBFS(px, py, maxDepth);
+    m_playerFieldValid = true;
+    m_playerFieldX = px;
+    m_playerFieldY = py;
+    m_playerFieldVersion = m_accessVersion;
+    m_playerFieldDepth = maxDepth;
+    m_playerBFSRuns++;
+}
+
 GraphObject::Direction StudentWorld::getDirectionToPlayer(int x, int y, int maxMoves) {
-    runBFS(m_player->getX(), m_player->getY(), m_grid_player);
+    updatePlayerField(maxMoves);
+    return readDirectionToPlayer(x, y, maxMoves);
+}
 
-    int dist = m_grid_player[x][y];
+GraphObject::Direction StudentWorld::readDirectionToPlayer(int x, int y, int maxMoves) const {
+    int dist = playerDistance(x, y);
     if (dist == -1 || dist > maxMoves) return GraphObject::none;
 
-    if (x + 1 <= 60 && m_grid_player[x + 1][y] != -1 && m_grid_player[x + 1][y] < dist) return GraphObject::right;
-    if (x - 1 >= 0 && m_grid_player[x - 1][y] != -1 && m_grid_player[x - 1][y] < dist) return GraphObject::left;
-    if (y + 1 <= 60 && m_grid_player[x][y + 1] != -1 && m_grid_player[x][y + 1] < dist) return GraphObject::up;
-    if (y - 1 >= 0 && m_grid_player[x][y - 1] != -1 && m_grid_player[x][y - 1] < dist) return GraphObject::down;
+    if (x + 1 <= 60 && playerDistance(x + 1, y) != -1 && playerDistance(x + 1, y) < dist) return GraphObject::right;
+    if (x - 1 >= 0 && playerDistance(x - 1, y) != -1 && playerDistance(x - 1, y) < dist) return GraphObject::left;
+    if (y + 1 <= 60 && playerDistance(x, y + 1) != -1 && playerDistance(x, y + 1) < dist) return GraphObject::up;
+    if (y - 1 >= 0 && playerDistance(x, y - 1) != -1 && playerDistance(x, y - 1) < dist) return GraphObject::down;
 
     return GraphObject::none;
-}
\ No newline at end of file
+}
+
+void StudentWorld::flagAreaAsDirty(int x, int y, int radius) {
+    DirtyArea area = { max(0, x - radius), max(0, y - radius), min(60, x + radius), min(60, y + radius) };
+    refreshWalkable(area.x1, area.y1, area.x2, area.y2);
+    m_accessVersion++;
+    m_dirtyAreas.push_back(area);
+}
+
+bool StudentWorld::hasExitSupport(int x, int y) const {
+    int want = m_grid_exit[x][y] - 1;
+    if (x + 1 <= 60 && m_grid_exit[x + 1][y] == want) return true;
+    if (x - 1 >= 0 && m_grid_exit[x - 1][y] == want) return true;
+    if (y + 1 <= 60 && m_grid_exit[x][y + 1] == want) return true;
+    if (y - 1 >= 0 && m_grid_exit[x][y - 1] == want) return true;
+    return false;
+}
+
+// Repairs m_grid_exit after local changes instead of re-flooding the whole map.
+// Blocked cells and everything that only reached the exit through them are
+// invalidated first; then invalidated and newly opened cells are re-seeded
+// from their valid neighbours and improvements are propagated outwards.
+void StudentWorld::repairExitField() {
+    int dirs[4][2] = { {0,1}, {0,-1}, {1,0}, {-1,0} };
+    vector<pair<int, int>> reseed;
+    queue<pair<int, int>> check;
+
+    for (const DirtyArea& area : m_dirtyAreas) {
+        for (int x = area.x1; x <= area.x2; x++) {
+            for (int y = area.y1; y <= area.y2; y++) {
+                if (m_grid_exit[x][y] == 0) continue; // the exit itself is never invalid
+                if (!isLocationAccessible(x, y)) {
+                    if (m_grid_exit[x][y] != -1) {
+                        m_grid_exit[x][y] = -1;
+                        for (auto& d : dirs) check.push({ x + d[0], y + d[1] });
+                    }
+                }
+                else {
+                    reseed.push_back({ x, y });
+                }
+            }
+        }
+    }
+    m_dirtyAreas.clear();
+
+    while (!check.empty()) {
+        auto curr = check.front(); check.pop();
+        int cx = curr.first;
+        int cy = curr.second;
+        if (cx < 0 || cx > 60 || cy < 0 || cy > 60) continue;
+        if (m_grid_exit[cx][cy] <= 0 || hasExitSupport(cx, cy)) continue;
+
+        m_grid_exit[cx][cy] = -1;
+        reseed.push_back({ cx, cy });
+        for (auto& d : dirs) check.push({ cx + d[0], cy + d[1] });
+    }
+
+    queue<pair<int, int>> q;
+    for (auto& cell : reseed) {
+        int cx = cell.first;
+        int cy = cell.second;
+        int best = -1;
+        for (auto& d : dirs) {
+            int nx = cx + d[0];
+            int ny = cy + d[1];
+            if (nx < 0 || nx > 60 || ny < 0 || ny > 60) continue;
+            int nd = m_grid_exit[nx][ny];
+            if (nd != -1 && (best == -1 || nd + 1 < best)) best = nd + 1;
+        }
+        if (best != -1 && (m_grid_exit[cx][cy] == -1 || best < m_grid_exit[cx][cy])) {
+            m_grid_exit[cx][cy] = best;
+            q.push(cell);
+        }
+        else if (m_grid_exit[cx][cy] != -1) {
+            q.push(cell);
+        }
+    }
+
+    while (!q.empty()) {
+        auto curr = q.front(); q.pop();
+        int cx = curr.first;
+        int cy = curr.second;
+        int dist = m_grid_exit[cx][cy];
+
+        for (auto& d : dirs) {
+            int nx = cx + d[0];
+            int ny = cy + d[1];
+
+            if (isLocationAccessible(nx, ny) && (m_grid_exit[nx][ny] == -1 || m_grid_exit[nx][ny] > dist + 1)) {
+                m_grid_exit[nx][ny] = dist + 1;
+                q.push({ nx, ny });
+            }
+        }
+    }
+}
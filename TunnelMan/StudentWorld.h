@@ -4,13 +4,31 @@
 #include "GameWorld.h"
 #include "GameConstants.h"
 #include "GraphObject.h"
+#include "Terrain.h"
+#include "SpatialIndex.h"
+#include "Random.h"
+#include "ActorPool.h"
+#include "ComponentTable.h"
+#include "Proximity.h"
+#include "TimerWheel.h"
+#include "PoissonDiskSampler.h"
+#include "RewindBuffer.h"
 #include <string>
 #include <vector>
 #include <queue>
+#include <utility>
+#include <future>
+#include <algorithm>
 
 class Actor;
 class Tunnelman;
-class Earth;
+class Protester;
+class Boulder;
+class ActivatableObject;
+class Squirt;
+struct ProtesterPlan;
+class SnapshotWriter;
+class SnapshotReader;
 
 class StudentWorld : public GameWorld
 {
@@ -24,16 +42,55 @@ public:
 
     // -- Accessors --
     Tunnelman* getPlayer() const { return m_player; }
+    virtual const Terrain* getTerrain() const { return &m_earth; }
+    virtual double getGenerationSeconds() const { return m_generationSeconds; }
+
+    // -- Threading --
+    virtual void setProtesterThreads(int threads) { m_protesterThreads = std::max(1, threads); }
+
+    // -- Level Pipeline --
+    virtual void prepareNextLevel();
+    virtual void finishPreparingLevel();
+
+    // -- Snapshots --
+    virtual bool saveSnapshot(std::vector<unsigned char>& out) const;
+    virtual bool restoreSnapshot(const std::vector<unsigned char>& in);
+
+    // -- Rewind --
+    virtual void setRewindEnabled(bool enabled);
+    virtual int rewind(int ticks);
+    virtual RewindStats getRewindStats() const;
+
+    // -- Randomness --
+    virtual void setSeed(uint64_t seed) { m_random.setSeed(seed); }
+    int randInt(int bound) { return m_random.nextInt(bound); } // all gameplay randomness comes from here
 
     // -- Earth/Physics Helpers --
     bool removeEarth(int x, int y);
     bool isEarthAt(int x, int y) const;
     bool isEarthBelow(int x, int y) const;
-    bool isBoulderAt(int x, int y, int radius = 3);
+    bool isBoulderAt(int x, int y, int radius = BOULDER_RADIUS);
     bool isLocationAccessible(int x, int y);
 
     // -- Game Logic Helpers --
     void addActor(Actor* actor);
+
+    // Actors live in the level's pool: build them with createActor/spawnActor, free them with destroyActor
+    template <typename T, typename... Args>
+    T* createActor(Args&&... args) {
+        return new (m_actorPool.allocate(sizeof(T))) T(std::forward<Args>(args)...);
+    }
+    template <typename T, typename... Args>
+    T* spawnActor(Args&&... args) {
+        T* actor = createActor<T>(std::forward<Args>(args)...);
+        addActor(actor);
+        trackActor(actor);
+        return actor;
+    }
+    void destroyActor(Actor* actor);
+    void actorMoved(Actor* actor, int oldX, int oldY);
+    void setProtesterRest(Protester* protester, int ticks);
+    void sleepUntilDugUnder(Boulder* boulder);
     void decreaseBarrelCount();
     void scanForItems(int x, int y, int radius);
 
@@ -46,28 +103,151 @@ public:
     // -- Pathfinding --
     GraphObject::Direction getDirectionToExit(int x, int y);
     GraphObject::Direction getDirectionToPlayer(int x, int y, int maxMoves);
+    void updatePlayerField(int maxDepth); // floods from the player out to maxDepth unless the field is current
+    GraphObject::Direction readDirectionToPlayer(int x, int y, int maxMoves) const; // field must reach maxMoves already
 
-    void flagGridAsDirty() { m_gridDirty = true; }
+    virtual unsigned long getPlayerBFSRuns() const { return m_playerBFSRuns; }
+    virtual unsigned long getPlayerBFSRunsSaved() const { return m_playerBFSRunsSaved; }
+
+    void flagGridAsDirty() { m_gridDirty = true; m_accessVersion++; }
+    void flagAreaAsDirty(int x, int y, int radius);
 
 private:
     Tunnelman* m_player;
-    Earth* m_earth[VIEW_WIDTH][VIEW_HEIGHT];
+    Terrain m_earth;
+    ActorPool m_actorPool; // declared before the actors so it outlives them
     std::vector<Actor*> m_actors;
+    Random m_random;
+    SpatialIndex m_actorIndex; // same actors as m_actors, bucketed by position
+
+    // Per-kind component tables over m_actors, filled by spawnActor from the static type.
+    // Protester timers hold the tick the protester next acts on, temporary
+    // pickup timers the tick they disappear on.
+    ComponentTable<Protester> m_protesters;
+    ComponentTable<Boulder> m_boulders;
+    ComponentTable<ActivatableObject> m_pickups;
+    ComponentTable<Squirt> m_squirts;
+
+    static const unsigned char PICKUP_TEMPORARY = 1;
+    static const unsigned char PICKUP_BY_PLAYER = 2;
+    static const unsigned char PICKUP_BY_ENEMY = 4;
+    static const unsigned char BOULDER_ASLEEP = 1; // stable on Earth; woken when that Earth is dug
+
+    // Sleeping actors cost nothing until the wheel hands them back on the tick they are due
+    int m_tick;
+    TimerWheel<Protester> m_protesterWakeups;
+    TimerWheel<ActivatableObject> m_pickupExpiries;
+    std::vector<Protester*> m_dueProtesters;
+    std::vector<ActivatableObject*> m_duePickups;
+
+    // Due protesters are planned together, across m_protesterThreads threads once
+    // there are enough of them to pay for it, then their plans are applied in order
+    static const size_t PARALLEL_PLAN_MIN = 512;
+    int m_protesterThreads;
+    std::vector<ProtesterPlan> m_protesterPlans;
+    std::vector<std::future<void>> m_planWorkers;
+
+    // Player pickups are only tested when the player moves or a new one appears,
+    // and then only those in the trigger buckets around the player
+    SpatialIndex m_pickupTriggers;
+    bool m_triggersStale;
+    int m_triggerX;
+    int m_triggerY;
+    std::vector<ActivatableObject*> m_baitPickups; // gold left for protesters, checked every tick
+    std::vector<ActivatableObject*> m_firedPickups;
+
+    // How far this tick's passes have got, so a timer set mid-tick counts from
+    // the same tick the old per-tick countdown would have
+    int m_protesterRowsVisited;
+    bool m_pickupPassDone;
 
     int m_barrelsLeft;
     int m_ticksSinceLastProtester;
     int m_targetNumProtesters;
     int m_protesterCount; // Kept for member variable compliance, but unused in logic loop
+    double m_generationSeconds; // time the last init() took, i.e. the level-transition stall
+
+    // A level's layout, built from nothing but its number and a copy of the
+    // world's random stream so it can be made on a worker thread
+    struct LevelPlan {
+        unsigned int level;
+        Terrain earth;                     // boulder footprints already dug out
+        uint64_t walkable[VIEW_HEIGHT];
+        std::vector<std::pair<int, int>> boulders;
+        std::vector<std::pair<int, int>> barrels;
+        std::vector<std::pair<int, int>> gold;
+        Random random;                     // the stream as generation left it
+    };
+    std::future<LevelPlan> m_nextLevel; // set by prepareNextLevel until init() takes it
+
+    // A snapshot of every tick of the level so far, as far back as the budget
+    // allows: 1 MB holds several minutes of play at ~100 bytes a tick
+    static const size_t REWIND_BUDGET = 1 << 20;
+    RewindBuffer m_rewind;
+    bool m_rewindEnabled;
+    std::vector<unsigned char> m_rewindFrame;
+    double m_lastRewindSeconds;
 
     int m_grid_exit[VIEW_WIDTH][VIEW_HEIGHT];
     int m_grid_player[VIEW_WIDTH][VIEW_HEIGHT];
+    unsigned int m_playerStamp[VIEW_WIDTH][VIEW_HEIGHT]; // m_grid_player[x][y] is only valid when stamped with m_playerEpoch
+    unsigned int m_playerEpoch;
     bool m_gridDirty;
 
+    // Locations whose accessibility may have changed since the exit field was last repaired
+    struct DirtyArea { int x1, y1, x2, y2; };
+    std::vector<DirtyArea> m_dirtyAreas;
+
+    // Bit x of row y is set when the 4x4 footprint at (x, y) is free of Earth and boulders
+    uint64_t m_walkable[VIEW_HEIGHT];
+
+    // Bumped whenever any location's accessibility may change (digging, boulders)
+    unsigned long m_accessVersion;
+
+    // m_grid_player is shared by every protester until the player moves or the map changes
+    bool m_playerFieldValid;
+    int m_playerFieldX;
+    int m_playerFieldY;
+    unsigned long m_playerFieldVersion;
+    int m_playerFieldDepth;
+    unsigned long m_playerBFSRuns;
+    unsigned long m_playerBFSRunsSaved;
+
     void updateDisplayText();
-    void distributeItems(int numBoulders, int numGold, int numBarrels);
-    bool isPositionValid(int x, int y);
+    void reapDeadActors();
+
+    // Update passes, one per component table; each returns the tick's status so far
+    int tickStatus();
+    int updateBoulders();
+    int updateProtesters();
+    void planProtesters(size_t begin, size_t end);
+    int updateSquirts();
+    int updatePickups();
+
+    void trackActor(Protester* protester);
+    void trackActor(Boulder* boulder);
+    void trackActor(ActivatableObject* pickup);
+    void trackActor(Squirt* squirt);
+    void wakeBouldersOver(int x, int y);
+    static LevelPlan generateLevel(unsigned int level, Random random);
+    static void distributeItems(LevelPlan& plan, Random& random, int numBoulders, int numGold, int numBarrels);
+    static void buildWalkable(LevelPlan& plan);
+
+    bool loadSnapshot(const std::vector<unsigned char>& in);
+    void saveActor(SnapshotWriter& out, const Actor* actor) const;
+    void recordRewindFrame();
+    template <typename T>
+    void restoreActor(T* actor, GraphObject::Direction dir, bool visible, SnapshotReader& in);
 
     void runBFS(int targetX, int targetY, int outputGrid[VIEW_WIDTH][VIEW_HEIGHT]);
+    void repairExitField();
+    bool computeAccessible(int x, int y);
+    void refreshWalkable(int x1, int y1, int x2, int y2);
+    void runBoundedPlayerBFS(int targetX, int targetY, int maxDepth);
+    int playerDistance(int x, int y) const {
+        return m_playerStamp[x][y] == m_playerEpoch ? m_grid_player[x][y] : -1;
+    }
+    bool hasExitSupport(int x, int y) const;
 };
 
 #endif // STUDENTWORLD_H_
\ No newline at end of file
@@ -0,0 +1,104 @@
+#ifndef TERRAIN_H_
+#define TERRAIN_H_
+
+#include "GameConstants.h"
+#include <cstdint>
+#include <cstring>
+
+static_assert(VIEW_WIDTH <= 64, "Terrain packs each row into a single 64-bit mask");
+
+// ============================================================================
+// TERRAIN
+// One 64-bit mask per row; bit x of row y is set while that Earth cell exists.
+// ============================================================================
+class Terrain
+{
+public:
+    Terrain() { clear(); }
+
+    void clear() {
+        for (int y = 0; y < VIEW_HEIGHT; y++) m_rows[y] = 0;
+    }
+
+    // Copies in the dirt every level starts with: rows below DIRT_HEIGHT, minus the shaft
+    void fillStartingLayout() {
+        std::memcpy(m_rows, startingLayout().rows, sizeof(m_rows));
+    }
+
+    void setCell(int x, int y) {
+        if (inBounds(x, y)) m_rows[y] |= uint64_t(1) << x;
+    }
+
+    bool isCellSet(int x, int y) const {
+        return inBounds(x, y) && ((m_rows[y] >> x) & 1);
+    }
+
+    // True if any cell in the w x h block whose lower-left corner is (x, y) is set
+    bool anyInBlock(int x, int y, int w, int h) const {
+        uint64_t mask = spanMask(x, w);
+        if (mask == 0) return false;
+        for (int j = clampLow(y); j < y + h && j < VIEW_HEIGHT; j++)
+            if (m_rows[j] & mask) return true;
+        return false;
+    }
+
+    // Clears the w x h block; returns true if at least one cell was set
+    bool clearBlock(int x, int y, int w, int h) {
+        uint64_t mask = spanMask(x, w);
+        if (mask == 0) return false;
+        bool cleared = false;
+        for (int j = clampLow(y); j < y + h && j < VIEW_HEIGHT; j++) {
+            if (m_rows[j] & mask) {
+                m_rows[j] &= ~mask;
+                cleared = true;
+            }
+        }
+        return cleared;
+    }
+
+    uint64_t getRow(int y) const { return m_rows[y]; }
+
+    static const int DIRT_HEIGHT = 60;
+    static const int SHAFT_LEFT = 30;
+    static const int SHAFT_WIDTH = 4;
+    static const int SHAFT_BOTTOM = 4;
+
+private:
+    uint64_t m_rows[VIEW_HEIGHT];
+
+    struct Layout { uint64_t rows[VIEW_HEIGHT]; };
+
+    // Built a row mask at a time on first use; function statics initialise thread-safely
+    static const Layout& startingLayout() {
+        static const Layout layout = makeStartingLayout();
+        return layout;
+    }
+
+    static Layout makeStartingLayout() {
+        Layout layout;
+        uint64_t full = spanMask(0, VIEW_WIDTH);
+        uint64_t shaft = spanMask(SHAFT_LEFT, SHAFT_WIDTH);
+        for (int y = 0; y < VIEW_HEIGHT; y++) {
+            if (y >= DIRT_HEIGHT) layout.rows[y] = 0;
+            else if (y >= SHAFT_BOTTOM) layout.rows[y] = full & ~shaft;
+            else layout.rows[y] = full;
+        }
+        return layout;
+    }
+
+    static bool inBounds(int x, int y) {
+        return x >= 0 && x < VIEW_WIDTH && y >= 0 && y < VIEW_HEIGHT;
+    }
+
+    static int clampLow(int v) { return v < 0 ? 0 : v; }
+
+    // Bits [x, x + w) clipped to the board
+    static uint64_t spanMask(int x, int w) {
+        if (x < 0) { w += x; x = 0; }
+        if (w <= 0 || x >= VIEW_WIDTH) return 0;
+        uint64_t bits = (w >= 64) ? ~uint64_t(0) : ((uint64_t(1) << w) - 1);
+        return bits << x;
+    }
+};
+
+#endif // TERRAIN_H_
@@ -0,0 +1,95 @@
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include <vector>
+#include <cstddef>
+
+// ============================================================================
+// TIMER WHEEL
+// Two-level hashed timer wheel. Wake-ups within the current 64-tick block sit
+// in a per-tick slot, later ones within the current 4,096-tick span in a
+// per-block slot that is cascaded down when its block starts, and anything
+// further out in an overflow list. Scheduling and cancelling are O(1) in the
+// number of pending items; advancing costs only what is due.
+// ============================================================================
+template <typename T>
+class TimerWheel
+{
+public:
+    TimerWheel() : m_now(0) {}
+
+    // Drops everything pending and makes `now` the last tick already advanced to
+    void reset(int now) {
+        for (int s = 0; s < SLOTS; s++) {
+            m_near[s].clear();
+            m_far[s].clear();
+        }
+        m_overflow.clear();
+        m_now = now;
+    }
+
+    // when must be later than the last tick advanced to
+    void schedule(T* item, int when) {
+        Entry entry = { item, when };
+        slotFor(when).push_back(entry);
+    }
+
+    // Does nothing if the item is not pending for that tick
+    void cancel(T* item, int when) {
+        if (when <= m_now) return;
+        std::vector<Entry>& slot = slotFor(when);
+        for (size_t k = 0; k < slot.size(); k++) {
+            if (slot[k].item == item && slot[k].when == when) {
+                slot[k] = slot.back();
+                slot.pop_back();
+                return;
+            }
+        }
+    }
+
+    // Moves the wheel forward to `tick`, appending whatever falls due on the way to `due`
+    void advance(int tick, std::vector<T*>& due) {
+        while (m_now < tick) {
+            m_now++;
+            if ((m_now & (SLOTS - 1)) == 0) cascade();
+            std::vector<Entry>& slot = m_near[m_now & (SLOTS - 1)];
+            for (const Entry& entry : slot) due.push_back(entry.item);
+            slot.clear();
+        }
+    }
+
+private:
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+
+    struct Entry { T* item; int when; };
+
+    int m_now;
+    std::vector<Entry> m_near[SLOTS];
+    std::vector<Entry> m_far[SLOTS];
+    std::vector<Entry> m_overflow;
+
+    std::vector<Entry>& slotFor(int when) {
+        if ((when >> SLOT_BITS) == (m_now >> SLOT_BITS)) return m_near[when & (SLOTS - 1)];
+        if ((when >> (2 * SLOT_BITS)) == (m_now >> (2 * SLOT_BITS))) return m_far[(when >> SLOT_BITS) & (SLOTS - 1)];
+        return m_overflow;
+    }
+
+    // Called as m_now enters a new block: re-files the entries that now belong closer in
+    void cascade() {
+        if (((m_now >> SLOT_BITS) & (SLOTS - 1)) == 0) {
+            std::vector<Entry> later;
+            for (const Entry& entry : m_overflow) {
+                std::vector<Entry>& slot = slotFor(entry.when);
+                if (&slot == &m_overflow) later.push_back(entry);
+                else slot.push_back(entry);
+            }
+            m_overflow.swap(later);
+        }
+        std::vector<Entry>& block = m_far[(m_now >> SLOT_BITS) & (SLOTS - 1)];
+        for (const Entry& entry : block) m_near[entry.when & (SLOTS - 1)].push_back(entry);
+        block.clear();
+    }
+};
+
+#endif // TIMERWHEEL_H_
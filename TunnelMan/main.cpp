@@ -2,6 +2,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstdint>
 #include <cstdlib>
 #include <ctime>
 using namespace std;
@@ -33,8 +34,15 @@ int main(int argc, char* argv[])
 		}
 	}
 
-	srand(static_cast<unsigned int>(time(nullptr)));
-
+	  // --record <file> logs the session's keys for TunnelManHeadless --replay;
+	  // --tick-rate <n> runs the simulation n times a second (default 30)
+	uint64_t seed = static_cast<uint64_t>(time(nullptr));
 	GameWorld* gw = createStudentWorld(assetDirectory);
+	gw->setSeed(seed);
+	for (int k = 1; k + 1 < argc; k++)
+		if (string(argv[k]) == "--record")
+			Game().recordInput(argv[k + 1], seed);
+		else if (string(argv[k]) == "--tick-rate")
+			Game().setTickRate(atof(argv[k + 1]));
 	Game().run(argc, argv, gw, "TunnelMan");
 }